@@ -0,0 +1,487 @@
+/*********************************************************************
+* bench :: ns/op for the board and move primitives, as CSV
+*
+* 	usage ::
+*		bench [-r rounds] [-t ms] [-l label] [-f filter]
+*
+*		-every benchmark walks the same fixed corpus of
+*		positions, so two runs differ only by the code
+*		-each round is sized to take about <ms> milliseconds,
+*		the median and fastest round are reported
+*		-<label> fills the first column, e.g. a commit id,
+*		so results from several runs can be concatenated
+*		-<filter> runs only benchmarks whose name contains it
+*
+* 	build ::
+*		cc -std=gnu11 -O2 -Iinclude bench/bench.c \
+*		   src/board.c src/move.c src/move_list.c src/util.c \
+*		   src/position.c src/move_gen.c src/zobrist.c src/eval.c \
+*		   src/position_pack.c src/fen.c src/move_cache.c \
+*		   src/stats.c src/arena.c -lpthread -o bench
+*
+* 	compare ::
+*		./bench -l $(git rev-parse --short HEAD) > new.csv
+*********************************************************************/
+#include "board.h"
+#include "move.h"
+#include "move_list.h"
+#include "position.h"
+#include "move_gen.h"
+#include "zobrist.h"
+#include "eval.h"
+#include "position_pack.h"
+#include "fen.h"
+#include "move_cache.h"
+#include "util.h"
+#include "bench_corpus.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#define BENCH_MAX_PROBES (BENCH_POSITIONS * 32 * NUM_ROWS * NUM_COLS)
+#define BENCH_LIST_MOVES 48
+
+//one origin / dest pair in one corpus position,
+//with everything is_move_legal() derives before dispatching
+typedef struct Bench_Probe
+{
+	size_t position;
+	Move move;
+	short row_diff;
+	short col_diff;
+	char origin_piece;
+	char dest_piece;
+} Bench_Probe;
+
+typedef struct Bench_Data
+{
+	Position positions[BENCH_POSITIONS];
+	char* rows[BENCH_POSITIONS][NUM_ROWS];
+	Packed_Position packed[BENCH_POSITIONS];
+	Move legal[BENCH_POSITIONS][MAX_MOVES];
+	size_t num_legal[BENCH_POSITIONS];
+
+	Bench_Probe* probes;		//every piece to every other square
+	size_t num_probes;
+	Bench_Probe* by_kind[NUM_PIECE_KINDS];	//probes split by moving piece
+	size_t num_by_kind[NUM_PIECE_KINDS];
+	Bench_Probe* lines;		//probes along a rank, file or diagonal
+	size_t num_lines;
+
+	Move_List list;
+	Move_Cache* cache;
+} Bench_Data;
+
+typedef size_t (*Bench_Fn)(Bench_Data* data, size_t reps);
+
+typedef struct Bench_Case
+{
+	const char* name;
+	Bench_Fn run;		//returns operations performed
+} Bench_Case;
+
+//results land here so the compiler cannot drop the work
+static volatile unsigned long long bench_sink;
+
+static size_t bench_get_piece(Bench_Data* data, size_t reps)
+{
+	unsigned long long sum = 0;
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t p = 0; p < BENCH_POSITIONS; ++p)
+			for(short row = 0; row < NUM_ROWS; ++row)
+				for(short col = 0; col < NUM_COLS; ++col)
+					sum += (unsigned char)get_piece(data->rows[p], row, col);
+	bench_sink = sum;
+	return reps * BENCH_POSITIONS * NUM_ROWS * NUM_COLS;
+}
+
+static size_t bench_set_piece(Bench_Data* data, size_t reps)
+{
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t p = 0; p < BENCH_POSITIONS; ++p)
+			for(short row = 0; row < NUM_ROWS; ++row)
+				for(short col = 0; col < NUM_COLS; ++col)
+					set_piece(data->rows[p], row, col, data->rows[p][row][col]);
+	bench_sink = (unsigned char)data->rows[0][0][0];
+	return reps * BENCH_POSITIONS * NUM_ROWS * NUM_COLS;
+}
+
+//each legal move is played and played back, two move_piece() calls
+static size_t bench_move_piece(Bench_Data* data, size_t reps)
+{
+	size_t ops = 0;
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t p = 0; p < BENCH_POSITIONS; ++p)
+			for(size_t i = 0; i < data->num_legal[p]; ++i)
+			{
+				Move move = data->legal[p][i];
+				Move back = { { move.dest[0], move.dest[1] }, { move.origin[0], move.origin[1] } };
+				char captured = data->rows[p][move.dest[0]][move.dest[1]];
+				move_piece(data->rows[p], move);
+				move_piece(data->rows[p], back);
+				data->rows[p][move.dest[0]][move.dest[1]] = captured;
+				ops += 2;
+			}
+	bench_sink = ops;
+	return ops;
+}
+
+static size_t bench_is_path_clear(Bench_Data* data, size_t reps)
+{
+	unsigned long long sum = 0;
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t i = 0; i < data->num_lines; ++i)
+		{
+			const Bench_Probe* probe = &data->lines[i];
+			sum += is_path_clear(data->rows[probe->position], probe->move.origin, probe->move.dest);
+		}
+	bench_sink = sum;
+	return reps * data->num_lines;
+}
+
+//one runner per validate_*, each fed only probes of its own piece
+#define BENCH_VALIDATE(name, kind, call) \
+static size_t bench_##name(Bench_Data* data, size_t reps) \
+{ \
+	unsigned long long sum = 0; \
+	const Bench_Probe* probes = data->by_kind[kind]; \
+	const size_t count = data->num_by_kind[kind]; \
+	for(size_t r = 0; r < reps; ++r) \
+		for(size_t i = 0; i < count; ++i) \
+		{ \
+			const Bench_Probe* probe = &probes[i]; \
+			char** board = data->rows[probe->position]; \
+			sum += (call); \
+		} \
+	bench_sink = sum; \
+	return reps * count; \
+}
+
+BENCH_VALIDATE(validate_pawn, 0, validate_pawn(board, probe->row_diff, probe->col_diff,
+			islower(probe->origin_piece) ? 1 : 6, probe->move.origin[0],
+			probe->origin_piece, probe->dest_piece))
+BENCH_VALIDATE(validate_knight, 1, validate_knight(board, probe->row_diff, probe->col_diff,
+			probe->origin_piece, probe->dest_piece))
+BENCH_VALIDATE(validate_bishop, 2, validate_bishop(board, probe->row_diff, probe->col_diff,
+			probe->origin_piece, probe->dest_piece, probe->move))
+BENCH_VALIDATE(validate_rook, 3, validate_rook(board, probe->row_diff, probe->col_diff,
+			probe->origin_piece, probe->dest_piece, probe->move))
+BENCH_VALIDATE(validate_king, 5, validate_king(board, probe->row_diff, probe->col_diff,
+			probe->origin_piece, probe->dest_piece))
+
+static size_t bench_is_move_legal(Bench_Data* data, size_t reps)
+{
+	unsigned long long sum = 0;
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t i = 0; i < data->num_probes; ++i)
+		{
+			const Bench_Probe* probe = &data->probes[i];
+			sum += is_move_legal(data->rows[probe->position], probe->move);
+		}
+	bench_sink = sum;
+	return reps * data->num_probes;
+}
+
+//a move list the size of a typical position, filled then emptied
+//front first, the order search would consume it in
+static size_t bench_add_remove_move(Bench_Data* data, size_t reps)
+{
+	const Move* moves = data->legal[3];
+	const size_t count = data->num_legal[3] < BENCH_LIST_MOVES ? data->num_legal[3] : BENCH_LIST_MOVES;
+	for(size_t r = 0; r < reps; ++r)
+	{
+		for(size_t i = 0; i < count; ++i)
+			add_move(&data->list, moves[i]);
+		for(size_t i = 0; i < count; ++i)
+			remove_move(&data->list, moves[i]);
+	}
+	bench_sink = data->list.size;
+	return reps * count * 2;
+}
+
+static size_t bench_generate_moves(Bench_Data* data, size_t reps)
+{
+	unsigned long long sum = 0;
+	Move_Set set;
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t p = 0; p < BENCH_POSITIONS; ++p)
+		{
+			generate_moves(&data->positions[p], &set);
+			sum += set.dests[0];
+		}
+	bench_sink = sum;
+	return reps * BENCH_POSITIONS;
+}
+
+static size_t bench_move_cache_generate(Bench_Data* data, size_t reps)
+{
+	unsigned long long sum = 0;
+	Move_Set set;
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t p = 0; p < BENCH_POSITIONS; ++p)
+		{
+			move_cache_generate(data->cache, &data->positions[p], &set);
+			sum += set.dests[0];
+		}
+	bench_sink = sum;
+	return reps * BENCH_POSITIONS;
+}
+
+static size_t bench_make_unmake(Bench_Data* data, size_t reps)
+{
+	size_t ops = 0;
+	Undo undo;
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t p = 0; p < BENCH_POSITIONS; ++p)
+			for(size_t i = 0; i < data->num_legal[p]; ++i)
+			{
+				position_make_move_undo(&data->positions[p], data->legal[p][i], &undo);
+				position_unmake_move(&data->positions[p], &undo);
+				ops++;
+			}
+	bench_sink = ops;
+	return ops;
+}
+
+static size_t bench_position_hash(Bench_Data* data, size_t reps)
+{
+	unsigned long long sum = 0;
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t p = 0; p < BENCH_POSITIONS; ++p)
+			sum += position_hash(&data->positions[p]);
+	bench_sink = sum;
+	return reps * BENCH_POSITIONS;
+}
+
+static size_t bench_evaluate(Bench_Data* data, size_t reps)
+{
+	unsigned long long sum = 0;
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t p = 0; p < BENCH_POSITIONS; ++p)
+			sum += (unsigned long long)evaluate(&data->positions[p]);
+	bench_sink = sum;
+	return reps * BENCH_POSITIONS;
+}
+
+static size_t bench_position_pack(Bench_Data* data, size_t reps)
+{
+	unsigned long long sum = 0;
+	Packed_Position packed;
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t p = 0; p < BENCH_POSITIONS; ++p)
+		{
+			position_pack(&data->positions[p], &packed);
+			sum += packed.occupancy;
+		}
+	bench_sink = sum;
+	return reps * BENCH_POSITIONS;
+}
+
+static size_t bench_position_unpack(Bench_Data* data, size_t reps)
+{
+	unsigned long long sum = 0;
+	Position pos;
+	for(size_t r = 0; r < reps; ++r)
+		for(size_t p = 0; p < BENCH_POSITIONS; ++p)
+		{
+			position_unpack(&data->packed[p], &pos);
+			sum += (unsigned char)pos.squares[0][0];
+		}
+	bench_sink = sum;
+	return reps * BENCH_POSITIONS;
+}
+
+static const Bench_Case BENCH_CASES[] = {
+	{ "get_piece",           bench_get_piece },
+	{ "set_piece",           bench_set_piece },
+	{ "move_piece",          bench_move_piece },
+	{ "is_path_clear",       bench_is_path_clear },
+	{ "validate_pawn",       bench_validate_pawn },
+	{ "validate_knight",     bench_validate_knight },
+	{ "validate_bishop",     bench_validate_bishop },
+	{ "validate_rook",       bench_validate_rook },
+	{ "validate_king",       bench_validate_king },
+	{ "is_move_legal",       bench_is_move_legal },
+	{ "add_remove_move",     bench_add_remove_move },
+	{ "generate_moves",      bench_generate_moves },
+	{ "move_cache_generate", bench_move_cache_generate },
+	{ "make_unmake",         bench_make_unmake },
+	{ "position_hash",       bench_position_hash },
+	{ "evaluate",            bench_evaluate },
+	{ "position_pack",       bench_position_pack },
+	{ "position_unpack",     bench_position_unpack }
+};
+#define BENCH_NUM_CASES (sizeof(BENCH_CASES) / sizeof(BENCH_CASES[0]))
+
+/*********************************************************************
+* static void bench_setup(Bench_Data* data)
+*
+* 	PURPOSE ::
+*  		parse the corpus and precompute every input, so the
+*  		timed loops do nothing but call the function measured
+*********************************************************************/
+static void bench_setup(Bench_Data* data)
+{
+	memset(data, 0, sizeof(*data));
+	zobrist_init();
+
+	data->probes = (Bench_Probe*)malloc(BENCH_MAX_PROBES * sizeof(Bench_Probe));
+	data->lines = (Bench_Probe*)malloc(BENCH_MAX_PROBES * sizeof(Bench_Probe));
+	if(!data->probes || !data->lines)
+		error_nomem();
+	for(size_t kind = 0; kind < NUM_PIECE_KINDS; ++kind)
+	{
+		data->by_kind[kind] = (Bench_Probe*)malloc(BENCH_MAX_PROBES * sizeof(Bench_Probe));
+		if(!data->by_kind[kind])
+			error_nomem();
+	}
+
+	for(size_t p = 0; p < BENCH_POSITIONS; ++p)
+	{
+		if(position_from_fen(&data->positions[p], BENCH_CORPUS[p]) != 0)
+		{
+			fprintf(stderr, "Bad corpus FEN : %s\n", BENCH_CORPUS[p]);
+			exit(EXIT_FAILURE);
+		}
+		position_rows(&data->positions[p], data->rows[p]);
+		position_pack(&data->positions[p], &data->packed[p]);
+
+		Move_Set set;
+		generate_moves(&data->positions[p], &set);
+		data->num_legal[p] = move_set_to_list(&set, data->legal[p]);
+
+		for(short origin = 0; origin < NUM_SQUARES; ++origin)
+		{
+			char piece = data->positions[p].squares[origin / NUM_COLS][origin % NUM_COLS];
+			int kind = piece_kind(piece);
+			if(kind == FAILURE)
+				continue;
+			for(short dest = 0; dest < NUM_SQUARES; ++dest)
+			{
+				if(dest == origin)
+					continue;
+				Bench_Probe probe;
+				probe.position = p;
+				probe.move = (Move){ { origin / NUM_COLS, origin % NUM_COLS },
+				                     { dest / NUM_COLS, dest % NUM_COLS } };
+				probe.row_diff = (short)abs(probe.move.origin[0] - probe.move.dest[0]);
+				probe.col_diff = (short)abs(probe.move.origin[1] - probe.move.dest[1]);
+				probe.origin_piece = piece;
+				probe.dest_piece = data->positions[p].squares[dest / NUM_COLS][dest % NUM_COLS];
+
+				data->probes[data->num_probes++] = probe;
+				data->by_kind[kind][data->num_by_kind[kind]++] = probe;
+				if(probe.row_diff == 0 || probe.col_diff == 0 || probe.row_diff == probe.col_diff)
+					data->lines[data->num_lines++] = probe;
+			}
+		}
+	}
+
+	data->list = init_list(BENCH_LIST_MOVES);
+	data->cache = move_cache_create(1 << 20, 4);
+	if(!data->cache)
+		error_nomem();
+	return;
+}
+
+static void bench_teardown(Bench_Data* data)
+{
+	move_cache_destroy(data->cache);
+	free_list(&data->list);
+	for(size_t kind = 0; kind < NUM_PIECE_KINDS; ++kind)
+		free(data->by_kind[kind]);
+	free(data->lines);
+	free(data->probes);
+	return;
+}
+
+static int bench_compare_doubles(const void* a, const void* b)
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: bench [-r rounds] [-t ms] [-l label] [-f filter]\n");
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+	size_t rounds = 7;
+	double round_ms = 20.0;
+	const char* label = "local";
+	const char* filter = NULL;
+
+	for(int arg = 1; arg < argc; ++arg)
+	{
+		if(argv[arg][0] != '-' || argv[arg][1] == '\0' || argv[arg][2] != '\0' || arg + 1 >= argc)
+			usage();
+		const char* value = argv[++arg];
+		char* end = NULL;
+		switch(argv[arg - 1][1])
+		{
+			case 'r':
+				rounds = (size_t)strtoul(value, &end, 10);
+				//strtoul() takes "-3" as a huge count
+				if(end == value || *end != '\0' || value[0] == '-' || rounds < 1)
+					usage();
+				break;
+			case 't':
+				//calibration doubles the repetitions until a round
+				//lasts this long, it has to be a time that comes
+				round_ms = strtod(value, &end);
+				if(end == value || *end != '\0' || !isfinite(round_ms) || round_ms <= 0.0)
+					usage();
+				break;
+			case 'l': label = value; break;
+			case 'f': filter = value; break;
+			default:  usage();
+		}
+	}
+
+	static Bench_Data data;
+	bench_setup(&data);
+	double* samples = (double*)malloc(rounds * sizeof(double));
+	if(!samples)
+		error_nomem();
+
+	printf("label,benchmark,ops_per_round,ns_per_op_median,ns_per_op_min\n");
+	for(size_t c = 0; c < BENCH_NUM_CASES; ++c)
+	{
+		const Bench_Case* bench = &BENCH_CASES[c];
+		if(filter && !strstr(bench->name, filter))
+			continue;
+
+		//grow the repetition count until one round fills round_ms,
+		//this doubles as the warm up
+		size_t reps = 1;
+		size_t ops = 0;
+		for(;;)
+		{
+			unsigned long long start = time_now_ns();
+			ops = bench->run(&data, reps);
+			if((double)(time_now_ns() - start) >= round_ms * 1e6 || reps >= ((size_t)1 << 30))
+				break;
+			reps *= 2;
+		}
+
+		for(size_t r = 0; r < rounds; ++r)
+		{
+			unsigned long long start = time_now_ns();
+			ops = bench->run(&data, reps);
+			samples[r] = (double)(time_now_ns() - start) / (double)(ops ? ops : 1);
+		}
+		qsort(samples, rounds, sizeof(double), bench_compare_doubles);
+		printf("%s,%s,%zu,%.3f,%.3f\n", label, bench->name, ops, samples[rounds / 2], samples[0]);
+		fflush(stdout);
+	}
+
+	free(samples);
+	bench_teardown(&data);
+	return 0;
+}
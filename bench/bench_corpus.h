@@ -0,0 +1,26 @@
+#ifndef BENCH_CORPUS_H_
+#define BENCH_CORPUS_H_
+
+//openings, middlegames and endings, never change these
+//or old results stop being comparable
+static const char* const BENCH_CORPUS[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",
+	"rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b - - 1 2",
+	"r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w - - 4 4",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w - - 0 1",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w - - 1 8",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	"2r3k1/pp3ppp/2n1b3/3p4/3P4/2PB1N2/P4PPP/4R1K1 b - - 3 21",
+	"r1b2rk1/2q1bppp/p2p1n2/np2p3/3PP3/2P2N1P/PPB2PP1/RNBQR1K1 w - - 0 13",
+	"3q1rk1/1b3ppp/p3p3/1p1nP3/3P4/P2B1N2/1P3PPP/R2Q1RK1 w - - 1 19",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"4k3/8/8/3PK3/8/8/8/8 w - - 0 1",
+	"8/8/4k3/8/2r5/8/3K4/5R2 b - - 10 50",
+	"6k1/5ppp/8/8/8/8/1q3PPP/3Q2K1 w - - 0 30",
+	"8/5pk1/6p1/7p/P6P/6P1/5PK1/8 b - - 0 40",
+	"r2q1rk1/ppp2ppp/2n1bn2/3p4/3P4/2NBPN2/PP3PPP/R2Q1RK1 b - - 5 9",
+	"1k6/ppp5/8/8/8/8/5PPP/3R2K1 w - - 0 35"
+};
+#define BENCH_POSITIONS (sizeof(BENCH_CORPUS) / sizeof(BENCH_CORPUS[0]))
+
+#endif //BENCH_CORPUS_H_
@@ -0,0 +1,174 @@
+/*********************************************************************
+* pool_bench :: game pool throughput and move latency, as CSV
+*
+* 	usage ::
+*		pool_bench [-j shards] [-g games] [-m moves] [-b batch]
+*		           [-w] [-l label]
+*
+*		-<games> games are opened at once and played with
+*		random legal moves, <batch> moves per submit, until
+*		<moves> have been sent, finished games start over
+*		-the driver keeps its own copy of every game to pick
+*		moves from, so it never waits on the pool to go on.
+*		Latency is then submit to answer with the shard
+*		queues full, the tail under saturation
+*		-w waits for every batch before sending the next,
+*		latency is then the service time alone
+*
+* 	build ::
+*		cc -std=gnu11 -O2 -Iinclude bench/pool_bench.c \
+*		   src/board.c src/move.c src/util.c src/position.c \
+*		   src/move_gen.c src/game_pool.c src/ring_queue.c \
+*		   src/latency.c src/stats.c src/arena.c \
+*		   -lpthread -o pool_bench
+*********************************************************************/
+#include "position.h"
+#include "move_gen.h"
+#include "game_pool.h"
+#include "util.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct Pool_Bench_Game
+{
+	Position pos;		//the driver's copy, a move ahead of the pool
+	short over;
+} Pool_Bench_Game;
+
+static unsigned long long pool_bench_random(unsigned long long* state)
+{
+	unsigned long long x = *state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: pool_bench [-j shards] [-g games] [-m moves] [-b batch] [-w] [-l label]\n");
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t num_shards = (cores > 0) ? (size_t)cores : 1;
+	size_t num_games = 10000;
+	unsigned long long total_moves = 1000000;
+	size_t batch = 256;
+	short closed_loop = FALSE;
+	const char* label = "local";
+
+	for(int arg = 1; arg < argc; ++arg)
+	{
+		if(argv[arg][0] != '-' || argv[arg][1] == '\0' || argv[arg][2] != '\0')
+			usage();
+		if(argv[arg][1] == 'w')
+		{
+			closed_loop = TRUE;
+			continue;
+		}
+		if(arg + 1 >= argc)
+			usage();
+		const char* value = argv[++arg];
+		switch(argv[arg - 1][1])
+		{
+			case 'j': num_shards = (size_t)strtoul(value, NULL, 10); break;
+			case 'g': num_games = (size_t)strtoul(value, NULL, 10); break;
+			case 'm': total_moves = strtoull(value, NULL, 10); break;
+			case 'b': batch = (size_t)strtoul(value, NULL, 10); break;
+			case 'l': label = value; break;
+			default: usage();
+		}
+	}
+	if(num_shards < 1 || num_games < 1 || total_moves < 1 || batch < 1)
+		usage();
+
+	Game_Pool* pool = game_pool_create(num_games, num_shards);
+	Pool_Bench_Game* games = (Pool_Bench_Game*)calloc(num_games, sizeof(Pool_Bench_Game));
+	Move_Request* requests = (Move_Request*)malloc(batch * sizeof(Move_Request));
+	if(!pool || !games || !requests)
+		error_nomem();
+	for(size_t g = 0; g < num_games; ++g)
+	{
+		if(game_pool_new_game(pool) != (long)g)
+			error_nomem();
+		position_init(&games[g].pos);
+	}
+
+	unsigned long long rng = 0x9E3779B97F4A7C15ULL;
+	unsigned long long sent = 0;
+	size_t live = num_games;
+	size_t cursor = 0;
+	game_pool_reset_stats(pool);
+	while(sent < total_moves)
+	{
+		//every game finished : once the pool has caught up, start over
+		if(live == 0)
+		{
+			game_pool_wait(pool);
+			for(size_t g = 0; g < num_games; ++g)
+			{
+				game_pool_reset_game(pool, g);
+				position_init(&games[g].pos);
+				games[g].over = FALSE;
+			}
+			live = num_games;
+		}
+
+		size_t count = 0;
+		for(size_t scanned = 0; scanned < num_games && count < batch &&
+				sent + count < total_moves; ++scanned)
+		{
+			Pool_Bench_Game* game = &games[cursor];
+			size_t id = cursor;
+			cursor = (cursor + 1) % num_games;
+			if(game->over)
+				continue;
+
+			Move_Set set;
+			Move moves[MAX_MOVES];
+			generate_moves(&game->pos, &set);
+			size_t legal = move_set_to_list(&set, moves);
+			if(legal == 0)
+			{
+				game->over = TRUE;
+				live--;
+				continue;
+			}
+
+			Move move = moves[pool_bench_random(&rng) % legal];
+			position_make_move(&game->pos, move);
+			if(position_status(&game->pos) != GAME_ONGOING)
+			{
+				game->over = TRUE;
+				live--;
+			}
+			requests[count].game = id;
+			requests[count].move = move;
+			count++;
+		}
+
+		sent += game_pool_submit(pool, requests, NULL, count);
+		if(closed_loop)
+			game_pool_wait(pool);
+	}
+	game_pool_wait(pool);
+
+	Pool_Stats stats;
+	game_pool_stats(pool, &stats);
+	printf("label,shards,games,batch,mode,moves,rejected,seconds,moves_per_sec,p50_us,p99_us,max_us\n");
+	printf("%s,%zu,%zu,%zu,%s,%llu,%llu,%.3f,%.0f,%.1f,%.1f,%.1f\n", label, num_shards,
+			num_games, batch, closed_loop ? "closed" : "open", stats.moves, stats.rejected,
+			stats.seconds, stats.moves_per_second, (double)stats.p50_ns / 1e3,
+			(double)stats.p99_ns / 1e3, (double)stats.max_ns / 1e3);
+
+	game_pool_destroy(pool);
+	free(requests);
+	free(games);
+	return 0;
+}
@@ -0,0 +1,184 @@
+/*********************************************************************
+* time_bench :: search response time against its budget, as CSV
+*
+* 	usage ::
+*		time_bench [-j threads] [-n searches] [-b ms,ms,...]
+*		           [-l label]
+*
+*		-<threads> searches run at once, each on its own
+*		table, to see the tail under load (default one per
+*		core)
+*		-every thread walks the fixed corpus with a fixed
+*		per-request budget, -n searches per thread per budget
+*		-p50 / p99 / max are wall time from the call to the
+*		returned move, overruns are searches past the budget
+*
+* 	build ::
+*		cc -std=gnu11 -O2 -Iinclude bench/time_bench.c \
+*		   src/board.c src/move.c src/util.c src/position.c \
+*		   src/move_gen.c src/zobrist.c src/eval.c src/fen.c \
+*		   src/tt.c src/search.c src/time_manager.c \
+*		   src/latency.c src/stats.c src/arena.c \
+*		   -lpthread -o time_bench
+*********************************************************************/
+#include "position.h"
+#include "fen.h"
+#include "search.h"
+#include "tt.h"
+#include "time_manager.h"
+#include "latency.h"
+#include "arena.h"
+#include "util.h"
+#include "bench_corpus.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define TIME_BENCH_TT_BYTES (8 << 20)
+#define TIME_BENCH_MAX_BUDGETS 16
+
+typedef struct Time_Bench_Job
+{
+	long long budget_ms;
+	size_t searches;
+	size_t first;			//corpus index to start from
+	Latency_Histogram latency;
+	size_t overruns;
+	unsigned long long depth_total;
+} Time_Bench_Job;
+
+static void* time_bench_worker(void* arg)
+{
+	Time_Bench_Job* job = (Time_Bench_Job*)arg;
+	Transposition_Table* tt = tt_create(TIME_BENCH_TT_BYTES);
+	Search_Context* ctx = search_create_in(arena_thread(), tt);
+	if(!tt || !ctx)
+		error_nomem();
+
+	latency_reset(&job->latency);
+	const unsigned long long budget_ns = (unsigned long long)job->budget_ms * 1000000ULL;
+	for(size_t i = 0; i < job->searches; ++i)
+	{
+		Position pos;
+		position_from_fen(&pos, BENCH_CORPUS[(job->first + i) % BENCH_POSITIONS]);
+		tt_clear(tt);
+
+		Time_Control tc;
+		memset(&tc, 0, sizeof(tc));
+		tc.movetime = job->budget_ms;
+		Time_Manager tm;
+		Search_Result result;
+		Search_Limits limits = { .time = &tm };
+
+		unsigned long long start = time_now_ns();
+		time_manager_start(&tm, &tc, pos.side);
+		search_position(ctx, &pos, &limits, &result);
+		unsigned long long took = time_now_ns() - start;
+
+		latency_record(&job->latency, took);
+		if(took > budget_ns)
+			job->overruns++;
+		job->depth_total += (unsigned long long)result.depth;
+	}
+
+	tt_destroy(tt);
+	arena_thread_release();
+	return NULL;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: time_bench [-j threads] [-n searches] [-b ms,ms,...] [-l label]\n");
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t num_threads = (cores > 0) ? (size_t)cores : 1;
+	size_t searches = 64;
+	const char* label = "local";
+	long long budgets[TIME_BENCH_MAX_BUDGETS] = { 10, 50, 100 };
+	size_t num_budgets = 3;
+
+	for(int arg = 1; arg < argc; ++arg)
+	{
+		if(argv[arg][0] != '-' || argv[arg][1] == '\0' || argv[arg][2] != '\0' || arg + 1 >= argc)
+			usage();
+		const char* value = argv[++arg];
+		switch(argv[arg - 1][1])
+		{
+			case 'j': num_threads = (size_t)strtoul(value, NULL, 10); break;
+			case 'n': searches = (size_t)strtoul(value, NULL, 10); break;
+			case 'l': label = value; break;
+			case 'b':
+			{
+				num_budgets = 0;
+				char* next = (char*)value;
+				while(*next && num_budgets < TIME_BENCH_MAX_BUDGETS)
+				{
+					budgets[num_budgets] = strtoll(next, &next, 10);
+					//a budget is a divisor below, and no search fits in 0 ms
+					if(budgets[num_budgets++] < 1)
+						usage();
+					if(*next == ',')
+						next++;
+					else if(*next)
+						usage();
+				}
+				break;
+			}
+			default: usage();
+		}
+	}
+	if(num_threads < 1 || searches < 1 || num_budgets < 1)
+		usage();
+
+	Time_Bench_Job* jobs = (Time_Bench_Job*)calloc(num_threads, sizeof(Time_Bench_Job));
+	pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+	if(!jobs || !threads)
+		error_nomem();
+
+	printf("label,budget_ms,threads,searches,p50_ms,p99_ms,max_ms,p99_over_budget,overruns,avg_depth\n");
+	for(size_t b = 0; b < num_budgets; ++b)
+	{
+		for(size_t t = 0; t < num_threads; ++t)
+		{
+			memset(&jobs[t], 0, sizeof(jobs[t]));
+			jobs[t].budget_ms = budgets[b];
+			jobs[t].searches = searches;
+			jobs[t].first = t;
+			if(pthread_create(&threads[t], NULL, time_bench_worker, &jobs[t]) != 0)
+			{
+				perror("Could not start a search thread\n\t{time_bench}\n");
+				return EXIT_FAILURE;
+			}
+		}
+
+		Latency_Histogram merged;
+		latency_reset(&merged);
+		size_t overruns = 0;
+		unsigned long long depth_total = 0;
+		for(size_t t = 0; t < num_threads; ++t)
+		{
+			pthread_join(threads[t], NULL);
+			latency_merge(&merged, &jobs[t].latency);
+			overruns += jobs[t].overruns;
+			depth_total += jobs[t].depth_total;
+		}
+
+		double p50 = (double)latency_percentile(&merged, 50.0) / 1e6;
+		double p99 = (double)latency_percentile(&merged, 99.0) / 1e6;
+		double max = (double)merged.max / 1e6;
+		printf("%s,%lld,%zu,%llu,%.3f,%.3f,%.3f,%.3f,%zu,%.1f\n", label, budgets[b], num_threads,
+				merged.total, p50, p99, max, p99 / (double)budgets[b], overruns,
+				(double)depth_total / (double)merged.total);
+		fflush(stdout);
+	}
+
+	free(threads);
+	free(jobs);
+	return 0;
+}
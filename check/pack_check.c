@@ -0,0 +1,256 @@
+/*********************************************************************
+* pack_check :: FEN and packed position round trips
+*
+* 	usage ::
+*		pack_check [-g games]
+*
+*		-every bench corpus position, every position met in
+*		<games> random games from each of them, and a few
+*		edge cases (empty board, 32 pieces, largest clocks)
+*		go FEN -> Position -> pack -> unpack -> FEN, singly
+*		and in bulk, and must come back unchanged
+*		-bulk calls must flag the slots that fail and leave
+*		them in a defined state
+*		-exits non-zero and prints the first few failures
+*		when anything does not
+*
+* 	build ::
+*		cc -std=gnu11 -O2 -Iinclude check/pack_check.c \
+*		   src/board.c src/move.c src/util.c src/position.c \
+*		   src/move_gen.c src/position_pack.c src/fen.c \
+*		   src/stats.c src/arena.c -o pack_check
+*
+*		add -U__SSE2__ to check the scalar occupancy path
+*********************************************************************/
+#include "position.h"
+#include "move_gen.h"
+#include "position_pack.h"
+#include "fen.h"
+#include "util.h"
+#include "../bench/bench_corpus.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CHECK_MAX_FAILURES 8
+#define CHECK_MAX_PLIES 400
+
+//FENs that must survive as written, to_fen() output is canonical
+static const char* const CHECK_EDGES[] = {
+	"8/8/8/8/8/8/8/8 w - - 0 1",
+	"8/8/8/8/8/8/8/8 b - - 65535 65535",
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b - - 65535 65535",
+	"kqrbnppp/pppppppp/8/8/8/8/PPPPPPPP/KQRBNPPP w - - 0 1",
+	"k7/8/8/8/8/8/8/7K b - - 99 1",
+	"7K/8/8/8/8/8/8/k7 w - - 100 65534"
+};
+#define CHECK_EDGE_COUNT (sizeof(CHECK_EDGES) / sizeof(CHECK_EDGES[0]))
+
+static size_t checked = 0;
+static size_t failures = 0;
+
+static void check_fail(const char* what, const char* fen, const char* got)
+{
+	if(++failures <= CHECK_MAX_FAILURES)
+		fprintf(stderr, "FAIL %s\n\twant %s\n\tgot  %s\n", what, fen, got ? got : "(none)");
+	return;
+}
+
+static int check_same(const Position* a, const Position* b)
+{
+	return memcmp(a->squares, b->squares, sizeof(a->squares)) == 0 && a->side == b->side &&
+		a->halfmove == b->halfmove && a->fullmove == b->fullmove;
+}
+
+/*********************************************************************
+* static void check_position(const Position* pos, const char* want)
+*
+* 	PURPOSE ::
+*  		round trip <pos> through FEN and the packed format,
+*  		singly and in bulk. <want> is the FEN it must print
+*  		as, NULL for whatever it prints as first
+*********************************************************************/
+static void check_position(const Position* pos, const char* want)
+{
+	char fen[FEN_MAX];
+	char again[FEN_MAX];
+	checked++;
+
+	if(position_to_fen(pos, fen, sizeof(fen)) != 0)
+	{
+		check_fail("to_fen", want ? want : "(position)", NULL);
+		return;
+	}
+	if(want && strcmp(fen, want) != 0)
+	{
+		check_fail("fen -> position -> fen", want, fen);
+		return;
+	}
+
+	Position parsed;
+	if(position_from_fen(&parsed, fen) != 0 || !check_same(&parsed, pos))
+	{
+		check_fail("fen reparse", fen, NULL);
+		return;
+	}
+
+	Packed_Position packed;
+	Position unpacked;
+	memset(&unpacked, 0, sizeof(unpacked));
+	if(position_pack(pos, &packed) != 0 || position_unpack(&packed, &unpacked) != 0)
+	{
+		check_fail("pack / unpack", fen, NULL);
+		return;
+	}
+	if(position_to_fen(&unpacked, again, sizeof(again)) != 0 || strcmp(fen, again) != 0 ||
+	   !check_same(&unpacked, pos))
+	{
+		check_fail("pack -> unpack -> fen", fen, again);
+		return;
+	}
+
+	Packed_Position bulk;
+	Position bulk_out;
+	short status = FAILURE;
+	if(position_pack_bulk(pos, &bulk, 1, &status) != 1 || status != 0 ||
+	   memcmp(&bulk, &packed, sizeof(bulk)) != 0)
+	{
+		check_fail("bulk pack", fen, NULL);
+		return;
+	}
+	status = FAILURE;
+	if(position_unpack_bulk(&bulk, &bulk_out, 1, &status) != 1 || status != 0 ||
+	   !check_same(&bulk_out, pos))
+		check_fail("bulk unpack", fen, NULL);
+	return;
+}
+/*********************************************************************
+* static void check_bulk_failures(void)
+*
+* 	PURPOSE ::
+*  		slots that fail in bulk are reported as such, and the
+*  		ones around them are untouched by it
+*  			-a failed pack is zeroed, a failed unpack is a
+*  			whole defined position, not leftover memory
+*********************************************************************/
+static void check_bulk_failures(void)
+{
+	Position in[3];
+	position_from_fen(&in[0], "k7/8/8/8/8/8/8/7K b - - 12 40");
+	position_from_fen(&in[1], "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1");
+	in[1].squares[4][4] = 'Q';
+	position_from_fen(&in[2], "8/8/8/8/8/8/8/8 b - - 3 7");
+
+	Packed_Position packed[3];
+	short status[3] = { FAILURE, 0, FAILURE };
+	checked++;
+	if(position_pack_bulk(in, packed, 3, status) != 2 || status[0] != 0 ||
+	   status[1] != FAILURE || status[2] != 0)
+		check_fail("bulk pack status", "0 FAILURE 0", NULL);
+	Packed_Position zero;
+	memset(&zero, 0, sizeof(zero));
+	if(memcmp(&packed[1], &zero, sizeof(zero)) != 0)
+		check_fail("bulk pack failed slot zeroed", "zeroes", NULL);
+
+	//a nibble that is no piece, under a set occupancy bit
+	packed[1].occupancy = 1;
+	packed[1].pieces[0] = 7;
+	Position out[3];
+	memset(out, 0x5A, sizeof(out));
+	status[0] = status[2] = FAILURE;
+	status[1] = 0;
+	checked++;
+	if(position_unpack_bulk(packed, out, 3, status) != 2 || status[0] != 0 ||
+	   status[1] != FAILURE || status[2] != 0)
+		check_fail("bulk unpack status", "0 FAILURE 0", NULL);
+	if(!check_same(&out[0], &in[0]) || !check_same(&out[2], &in[2]))
+		check_fail("bulk unpack around a failure", "both neighbours intact", NULL);
+	Position empty;
+	position_from_fen(&empty, "8/8/8/8/8/8/8/8 w - - 0 1");
+	if(!check_same(&out[1], &empty))
+		check_fail("bulk unpack failed slot", "8/8/8/8/8/8/8/8 w - - 0 1", NULL);
+	return;
+}
+
+static unsigned long long check_random(unsigned long long* state)
+{
+	unsigned long long x = *state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+int main(int argc, char** argv)
+{
+	int games = 64;
+	if(argc == 3 && strcmp(argv[1], "-g") == 0)
+		games = atoi(argv[2]);
+	else if(argc != 1)
+	{
+		fprintf(stderr, "usage: pack_check [-g games]\n");
+		return EXIT_FAILURE;
+	}
+
+	for(size_t i = 0; i < CHECK_EDGE_COUNT; ++i)
+	{
+		Position pos;
+		if(position_from_fen(&pos, CHECK_EDGES[i]) != 0)
+		{
+			check_fail("from_fen", CHECK_EDGES[i], NULL);
+			continue;
+		}
+		check_position(&pos, CHECK_EDGES[i]);
+	}
+
+	//more pieces than the format holds must be refused, not truncated
+	Position crowded;
+	position_from_fen(&crowded, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1");
+	crowded.squares[4][4] = 'Q';
+	Packed_Position packed;
+	checked++;
+	if(position_pack(&crowded, &packed) != FAILURE)
+		check_fail("33 pieces refused", "FAILURE", "0");
+	check_bulk_failures();
+
+	unsigned long long rng = 0x9E3779B97F4A7C15ULL;
+	for(size_t i = 0; i < BENCH_POSITIONS; ++i)
+	{
+		Position start;
+		if(position_from_fen(&start, BENCH_CORPUS[i]) != 0)
+		{
+			check_fail("from_fen", BENCH_CORPUS[i], NULL);
+			continue;
+		}
+		check_position(&start, BENCH_CORPUS[i]);
+
+		//random games from here reach boards no one would write down
+		for(int game = 0; game < games; ++game)
+		{
+			Position pos = start;
+			for(int ply = 0; ply < CHECK_MAX_PLIES && position_status(&pos) == GAME_ONGOING; ++ply)
+			{
+				Move_Set set;
+				Move moves[MAX_MOVES];
+				generate_moves(&pos, &set);
+				size_t count = move_set_to_list(&set, moves);
+				if(count == 0)
+					break;
+				position_make_move(&pos, moves[check_random(&rng) % count]);
+				check_position(&pos, NULL);
+			}
+		}
+	}
+
+	printf("%s %zu positions, %zu failures (%s occupancy)\n", failures ? "FAILED" : "ok",
+			checked, failures,
+#ifdef __SSE2__
+			"SSE2"
+#else
+			"scalar"
+#endif
+			);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/*********************************************************************
+* self_play_check :: self-play adjudication
+*
+* 	usage ::
+*		self_play_check
+*
+*		-each position is played out the way a self-play
+*		worker plays it, adjudicate then search then move,
+*		and must end the way chess says it ends. Moves are
+*		pseudo-legal, so a stalemate would otherwise go on
+*		to a king capture and be scored as a win
+*		-exits non-zero and prints every game that does not
+*
+* 	build ::
+*		cc -std=gnu11 -O2 -Iinclude check/self_play_check.c \
+*		   src/board.c src/move.c src/util.c src/position.c \
+*		   src/move_gen.c src/position_pack.c src/fen.c \
+*		   src/eval.c src/zobrist.c src/tt.c src/search.c \
+*		   src/time_manager.c src/self_play.c src/ring_queue.c \
+*		   src/stats.c src/arena.c -lpthread -lm -o self_play_check
+*********************************************************************/
+#include "position.h"
+#include "self_play.h"
+#include "search.h"
+#include "tt.h"
+#include "zobrist.h"
+#include "fen.h"
+#include "util.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+#define CHECK_NODES 20000
+#define CHECK_MAX_PLIES 40
+
+typedef struct Check_Game
+{
+	const char* fen;
+	Game_Status want;
+} Check_Game;
+
+static const Check_Game CHECK_GAMES[] = {
+	//stalemated, not in check, every king move walks into the queen
+	{ "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", GAME_DRAW },
+	{ "k7/2Q5/1K6/8/8/8/8/8 b - - 0 1", GAME_DRAW },
+	//pawn blocked, king boxed in : still stalemate
+	{ "k7/P7/1K6/8/8/8/8/8 b - - 0 1", GAME_DRAW },
+	//mated, in check with every move losing the king
+	{ "7k/6Q1/5K2/8/8/8/8/8 b - - 0 1", GAME_WHITE_WINS },
+	//Qf7 would stalemate, white has to find Qf8 mate
+	{ "7k/8/5QK1/8/8/8/8/8 w - - 0 1", GAME_WHITE_WINS }
+};
+#define CHECK_GAME_COUNT (sizeof(CHECK_GAMES) / sizeof(CHECK_GAMES[0]))
+
+static const char* check_status_name(Game_Status status)
+{
+	switch(status)
+	{
+		case GAME_WHITE_WINS: return "white wins";
+		case GAME_BLACK_WINS: return "black wins";
+		case GAME_DRAW: return "draw";
+		default: return "ongoing";
+	}
+}
+
+/*********************************************************************
+* static Game_Status check_play(Search_Context* ctx, Position* pos)
+*
+* 	PURPOSE ::
+*  		play <pos> out as self_play_step() does, GAME_ONGOING
+*  		if CHECK_MAX_PLIES pass without a result
+*********************************************************************/
+static Game_Status check_play(Search_Context* ctx, Position* pos)
+{
+	unsigned long long history[CHECK_MAX_PLIES + 1];
+	history[0] = position_hash(pos);
+	for(size_t plies = 0; plies < CHECK_MAX_PLIES; )
+	{
+		Game_Status status = self_play_adjudicate(pos, history, plies, MAX_GAME_PLIES);
+		if(status != GAME_ONGOING)
+			return status;
+
+		Search_Limits limits = { .nodes = CHECK_NODES };
+		Search_Result result;
+		if(search_position(ctx, pos, &limits, &result) != 0)
+			return GAME_DRAW;
+		if(result.score > MATE_BOUND || result.score < -MATE_BOUND)
+		{
+			short mover_wins = (result.score > 0);
+			short white_moves = (pos->side == WHITE);
+			return (mover_wins == white_moves) ? GAME_WHITE_WINS : GAME_BLACK_WINS;
+		}
+
+		position_make_move(pos, result.best);
+		history[++plies] = position_hash(pos);
+	}
+	return GAME_ONGOING;
+}
+
+int main(void)
+{
+	Transposition_Table* tt = tt_create(1 << 20);
+	Search_Context* ctx = search_create(tt);
+	if(!tt || !ctx)
+		error_nomem();
+
+	size_t failures = 0;
+	for(size_t i = 0; i < CHECK_GAME_COUNT; ++i)
+	{
+		Position pos;
+		if(position_from_fen(&pos, CHECK_GAMES[i].fen) != 0)
+		{
+			fprintf(stderr, "FAIL from_fen %s\n", CHECK_GAMES[i].fen);
+			failures++;
+			continue;
+		}
+		tt_clear(tt);
+		Game_Status got = check_play(ctx, &pos);
+		if(got != CHECK_GAMES[i].want)
+		{
+			fprintf(stderr, "FAIL %s\n\twant %s\n\tgot  %s\n", CHECK_GAMES[i].fen,
+					check_status_name(CHECK_GAMES[i].want), check_status_name(got));
+			failures++;
+		}
+	}
+
+	search_destroy(ctx);
+	tt_destroy(tt);
+	printf("%s %zu games, %zu failures\n", failures ? "FAILED" : "ok", CHECK_GAME_COUNT, failures);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+/*********************************************************************
+* validate_check :: batch validation against the single-move check
+*
+* 	usage ::
+*		validate_check [-g games]
+*
+*		-every bench corpus position and every position met
+*		in <games> random games from each of them is asked
+*		about all 4096 origin / dest pairs, through
+*		validate_batch() and validate_batch_cached(), and
+*		each verdict must match position_is_move_legal()
+*		-requests cycle through more positions than the
+*		lookaside holds, so evicted sets get regenerated
+*		-exits non-zero and prints the first few mismatches
+*
+* 	build ::
+*		cc -std=gnu11 -O2 -Iinclude check/validate_check.c \
+*		   src/board.c src/move.c src/util.c src/position.c \
+*		   src/move_gen.c src/zobrist.c src/move_cache.c \
+*		   src/batch_validate.c src/fen.c src/stats.c \
+*		   src/arena.c -lpthread -o validate_check
+*********************************************************************/
+#include "position.h"
+#include "move_gen.h"
+#include "move_cache.h"
+#include "batch_validate.h"
+#include "fen.h"
+#include "util.h"
+#include "../bench/bench_corpus.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CHECK_MAX_FAILURES 8
+#define CHECK_MAX_PLIES 100
+//positions asked about together, more than the lookaside holds
+#define CHECK_GROUP (VALIDATE_LOOKASIDE + 3)
+#define CHECK_PAIRS (NUM_ROWS * NUM_COLS * NUM_ROWS * NUM_COLS)
+
+static size_t checked = 0;
+static size_t failures = 0;
+
+static unsigned long long check_random(unsigned long long* state)
+{
+	unsigned long long x = *state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+static Move check_pair(size_t pair)
+{
+	Move move;
+	move.origin[0] = (short)(pair / 512);
+	move.origin[1] = (short)(pair / 64 % 8);
+	move.dest[0] = (short)(pair / 8 % 8);
+	move.dest[1] = (short)(pair % 8);
+	return move;
+}
+
+/*********************************************************************
+* static void check_group(Move_Cache* cache, const Position* group,
+*		size_t size, Validate_Request* requests,
+*		unsigned long long* verdicts)
+*
+* 	PURPOSE ::
+*  		ask every pair about every position of <group>, the
+*  		positions taking turns request by request, and hold
+*  		both batch calls to position_is_move_legal()
+*********************************************************************/
+static void check_group(Move_Cache* cache, const Position* group, size_t size,
+		Validate_Request* requests, unsigned long long* verdicts)
+{
+	size_t count = size * CHECK_PAIRS;
+	for(size_t i = 0; i < count; ++i)
+	{
+		requests[i].position = &group[i % size];
+		requests[i].move = check_pair(i / size);
+	}
+
+	for(int cached = 0; cached < 2; ++cached)
+	{
+		size_t legal = cached ? validate_batch_cached(cache, requests, count, verdicts)
+			: validate_batch(requests, count, verdicts);
+		size_t want_legal = 0;
+		for(size_t i = 0; i < count; ++i)
+		{
+			Position copy = *requests[i].position;
+			int want = (position_is_move_legal(&copy, requests[i].move) == TRUE);
+			want_legal += (size_t)want;
+			checked++;
+			if((int)VERDICT_GET(verdicts, i) == want)
+				continue;
+			if(++failures <= CHECK_MAX_FAILURES)
+			{
+				char fen[FEN_MAX];
+				char coord[6];
+				position_to_fen(requests[i].position, fen, sizeof(fen));
+				move_to_coord(requests[i].move, coord);
+				fprintf(stderr, "FAIL %s %s %s\n\twant %d got %d\n",
+						cached ? "validate_batch_cached" : "validate_batch", fen, coord,
+						want, (int)VERDICT_GET(verdicts, i));
+			}
+		}
+		if(legal != want_legal && ++failures <= CHECK_MAX_FAILURES)
+			fprintf(stderr, "FAIL legal count\n\twant %zu got %zu\n", want_legal, legal);
+	}
+	return;
+}
+
+//queue <pos> for checking, checking the group first once it is full
+static void check_add(Move_Cache* cache, Position* group, size_t* size, const Position* pos,
+		Validate_Request* requests, unsigned long long* verdicts)
+{
+	if(*size == CHECK_GROUP)
+	{
+		check_group(cache, group, *size, requests, verdicts);
+		*size = 0;
+	}
+	group[(*size)++] = *pos;
+	return;
+}
+
+int main(int argc, char** argv)
+{
+	int games = 2;
+	if(argc == 3 && strcmp(argv[1], "-g") == 0)
+		games = atoi(argv[2]);
+	else if(argc != 1)
+	{
+		fprintf(stderr, "usage: validate_check [-g games]\n");
+		return EXIT_FAILURE;
+	}
+
+	Move_Cache* cache = move_cache_create(1 << 20, 0);
+	Validate_Request* requests = (Validate_Request*)malloc(CHECK_GROUP * CHECK_PAIRS *
+			sizeof(Validate_Request));
+	unsigned long long* verdicts = (unsigned long long*)malloc(VERDICT_WORDS(CHECK_GROUP *
+			CHECK_PAIRS) * sizeof(unsigned long long));
+	if(!cache || !requests || !verdicts)
+		error_nomem();
+
+	Position group[CHECK_GROUP];
+	size_t size = 0;
+	unsigned long long rng = 0x9E3779B97F4A7C15ULL;
+	for(size_t i = 0; i < BENCH_POSITIONS; ++i)
+	{
+		Position start;
+		if(position_from_fen(&start, BENCH_CORPUS[i]) != 0)
+		{
+			fprintf(stderr, "FAIL from_fen %s\n", BENCH_CORPUS[i]);
+			failures++;
+			continue;
+		}
+		check_add(cache, group, &size, &start, requests, verdicts);
+
+		for(int game = 0; game < games; ++game)
+		{
+			Position pos = start;
+			for(int ply = 0; ply < CHECK_MAX_PLIES && position_status(&pos) == GAME_ONGOING; ++ply)
+			{
+				Move_Set set;
+				Move moves[MAX_MOVES];
+				generate_moves(&pos, &set);
+				size_t count = move_set_to_list(&set, moves);
+				if(count == 0)
+					break;
+				position_make_move(&pos, moves[check_random(&rng) % count]);
+				check_add(cache, group, &size, &pos, requests, verdicts);
+			}
+		}
+	}
+	if(size > 0)
+		check_group(cache, group, size, requests, verdicts);
+
+	printf("%s %zu verdicts, %zu failures\n", failures ? "FAILED" : "ok", checked, failures);
+	free(verdicts);
+	free(requests);
+	move_cache_destroy(cache);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
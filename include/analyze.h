@@ -0,0 +1,246 @@
+#ifndef ANALYZE_H_
+#define ANALYZE_H_
+
+///user defined
+#include "position.h"
+#include "search.h"
+#include "tt.h"
+#include "fen.h"
+#include "stats.h"
+#include "arena.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct Analyze_Config
+{
+	size_t num_threads;		//0 for one per core
+	int depth;			//depth every position is searched to
+	int multipv;			//root lines per position, <= MAX_MULTIPV
+	size_t tt_bytes;		//table size per thread
+} Analyze_Config;
+
+//one position of a batch, filled in place by analyze_batch()
+typedef struct Analyze_Job
+{
+	Position position;
+	Search_Result result;
+	short status;			//search_position()'s return
+} Analyze_Job;
+
+void analyze_defaults(Analyze_Config* config);
+short analyze_batch(Analyze_Job* jobs, size_t count, const Analyze_Config* config);
+void analyze_print(FILE* out, const Analyze_Job* job, size_t index);
+
+#ifdef ANALYZE_IMPLEMENTATION_
+
+//state shared by every worker of one batch
+typedef struct Analyze_Shared
+{
+	Analyze_Job* jobs;
+	size_t count;
+	const Analyze_Config* config;
+	atomic_size_t next;		//first job nobody has claimed
+} Analyze_Shared;
+
+/*********************************************************************
+* void analyze_defaults(Analyze_Config* config)
+*
+* 	PURPOSE ::
+*  		fill <config> with settings that suit overnight runs
+*
+* 	@param
+*	 - config :: overwritten
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void analyze_defaults(Analyze_Config* config)
+{
+	memset(config, 0, sizeof(*config));
+	config->num_threads = 0;
+	config->depth = 8;
+	config->multipv = 3;
+	config->tt_bytes = 32 << 20;
+	return;
+}
+/*********************************************************************
+* static void analyze_claim(Analyze_Shared* shared, Search_Context* ctx)
+*
+* 	PURPOSE ::
+*  		claim positions one at a time until the batch is done
+*  			-positions differ a lot in cost, so they are
+*  			handed out as threads free up rather than split
+*  			into equal shares up front
+*  			-the table is kept from one position to the
+*  			next, tt_new_search() ages what is left over
+*  			-touches no thread-local state, so the batch can
+*  			run inline on the caller's thread
+*********************************************************************/
+static void analyze_claim(Analyze_Shared* shared, Search_Context* ctx)
+{
+	const Analyze_Config* config = shared->config;
+	Search_Limits limits = { .depth = config->depth, .multipv = config->multipv };
+	for(;;)
+	{
+		size_t i = atomic_fetch_add(&shared->next, 1);
+		if(i >= shared->count)
+			break;
+		Analyze_Job* job = &shared->jobs[i];
+		job->status = (short)search_position(ctx, &job->position, &limits, &job->result);
+	}
+	return;
+}
+/*********************************************************************
+* static void* analyze_worker(void* arg)
+*
+* 	PURPOSE ::
+*  		thread entry : analyze_claim() with a table of its own
+*  		and a search stack on this thread's arena, counters
+*  		registered for stats
+*********************************************************************/
+static void* analyze_worker(void* arg)
+{
+	Analyze_Shared* shared = (Analyze_Shared*)arg;
+	stats_register_thread();
+
+	Transposition_Table* tt = tt_create(shared->config->tt_bytes);
+	if(!tt)
+		error_nomem();
+	Search_Context* ctx = search_create_in(arena_thread(), tt);
+	if(!ctx)
+		error_nomem();
+
+	analyze_claim(shared, ctx);
+
+	tt_destroy(tt);
+	arena_thread_release();
+	stats_unregister_thread();
+	return NULL;
+}
+/*********************************************************************
+* short analyze_batch(Analyze_Job* jobs, size_t count,
+*		const Analyze_Config* config)
+*
+* 	PURPOSE ::
+*  		search every position of <jobs> to config->depth with
+*  		config->multipv lines each, on every core
+*  			-each thread has its own table and search
+*  			stack, nothing is shared but the job counter
+*  			-results land in the jobs themselves, in input
+*  			order whatever order they finish in
+*
+* 	@param
+*	 - jobs   :: <count> positions, result and status overwritten
+*	 - count  :: batch size
+*	 - config :: see analyze_defaults()
+*
+*	 @return
+*	 - 0       :: success, see each job's status
+*	 - FAILURE :: bad config
+*********************************************************************/
+short analyze_batch(Analyze_Job* jobs, size_t count, const Analyze_Config* config)
+{
+	if(!jobs || !config || config->depth < 1 || config->depth >= MAX_PLY ||
+	   config->multipv < 1 || config->multipv > MAX_MULTIPV)
+	{
+		fprintf(stderr, "Bad analysis configuration\n");
+		return FAILURE;
+	}
+
+	size_t num_threads = config->num_threads;
+	if(num_threads == 0)
+	{
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		num_threads = (cores > 0) ? (size_t)cores : 1;
+	}
+	if(num_threads > count)
+		num_threads = count ? count : 1;
+
+	Analyze_Shared shared;
+	shared.jobs = jobs;
+	shared.count = count;
+	shared.config = config;
+	atomic_init(&shared.next, 0);
+
+	zobrist_init();
+	pthread_t* workers = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+	if(!workers)
+		error_nomem();
+	size_t started = 0;
+	for(size_t i = 0; i < num_threads; ++i)
+		if(pthread_create(&workers[started], NULL, analyze_worker, &shared) == 0)
+			started++;
+	//the threads that did start pick up the missing ones' share,
+	//with none at all the batch runs here, on a context of its own
+	//so the caller's thread arena and stats slot are left alone
+	if(started == 0)
+	{
+		Transposition_Table* tt = tt_create(config->tt_bytes);
+		if(!tt)
+			error_nomem();
+		Search_Context* ctx = search_create(tt);
+		if(!ctx)
+			error_nomem();
+		analyze_claim(&shared, ctx);
+		search_destroy(ctx);
+		tt_destroy(tt);
+	}
+	for(size_t i = 0; i < started; ++i)
+		pthread_join(workers[i], NULL);
+
+	free(workers);
+	return 0;
+}
+/*********************************************************************
+* void analyze_print(FILE* out, const Analyze_Job* job, size_t index)
+*
+* 	PURPOSE ::
+*  		write one analysed position, a header line then one
+*  		line per root move :
+*  			position 3 depth 8 nodes 91234 fen ...
+*  			  1 score 35 pv e2e4 e7e5 ...
+*
+* 	@param
+*	 - out   :: stream to write to
+*	 - job   :: a job analyze_batch() has finished
+*	 - index :: number to print for it
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void analyze_print(FILE* out, const Analyze_Job* job, size_t index)
+{
+	char fen[128];
+	if(position_to_fen(&job->position, fen, sizeof(fen)) != 0)
+		fen[0] = '\0';
+	if(job->status != 0)
+	{
+		fprintf(out, "position %zu no moves fen %s\n", index, fen);
+		return;
+	}
+
+	const Search_Result* result = &job->result;
+	fprintf(out, "position %zu depth %d nodes %llu fen %s\n", index, result->depth,
+			result->nodes, fen);
+	for(int l = 0; l < result->num_lines; ++l)
+	{
+		const Search_Line* line = &result->lines[l];
+		fprintf(out, "  %d score %d pv", l + 1, line->score);
+		for(int i = 0; i < line->pv_length; ++i)
+		{
+			char coord[6];
+			move_to_coord(line->pv[i], coord);
+			fprintf(out, " %s", coord);
+		}
+		fputc('\n', out);
+	}
+	return;
+}
+#endif //ANALYZE_IMPLEMENTATION_
+#endif //ANALYZE_H_
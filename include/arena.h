@@ -0,0 +1,447 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+///user defined
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define ARENA_ALIGN 16
+#define ARENA_DEFAULT_BLOCK (64 * 1024)
+
+//one malloc'd chunk, allocations are carved from it front to back
+typedef struct Arena_Block
+{
+	struct Arena_Block* next;
+	size_t size;
+	size_t used;
+	_Alignas(ARENA_ALIGN) unsigned char data[];
+} Arena_Block;
+
+typedef struct Arena_Stats
+{
+	unsigned long long allocations;	//arena_alloc() calls since creation
+	unsigned long long resets;
+	size_t bytes_in_use;		//carved out and not yet reset
+	size_t peak_bytes;
+	size_t bytes_reserved;		//held from the heap
+	size_t blocks;
+} Arena_Stats;
+
+//bump allocator owned by one thread.
+//nothing is freed on its own, arena_reset() or arena_release()
+//hand everything back at once and keep the blocks for reuse,
+//so a long run settles on a fixed set of heap blocks
+typedef struct Arena
+{
+	Arena_Block* first;
+	Arena_Block* current;
+	size_t block_size;
+	void* last;			//most recent allocation, can grow in place
+	Arena_Stats stats;
+} Arena;
+
+//a point to roll back to
+typedef struct Arena_Mark
+{
+	Arena_Block* block;
+	size_t used;
+	size_t bytes_in_use;
+} Arena_Mark;
+
+//every arena in the process, for leak tracking
+typedef struct Arena_Global_Stats
+{
+	size_t arenas;
+	size_t blocks;
+	size_t bytes_reserved;
+} Arena_Global_Stats;
+
+Arena* arena_create(size_t block_size);
+void arena_destroy(Arena* arena);
+void* arena_alloc(Arena* arena, size_t bytes);
+void* arena_alloc_zero(Arena* arena, size_t bytes);
+void* arena_grow(Arena* arena, void* old, size_t old_bytes, size_t new_bytes);
+void arena_reset(Arena* arena);
+Arena_Mark arena_mark(const Arena* arena);
+void arena_release(Arena* arena, Arena_Mark mark);
+void arena_stats(const Arena* arena, Arena_Stats* stats);
+Arena* arena_thread(void);
+void arena_thread_release(void);
+void arena_global_stats(Arena_Global_Stats* stats);
+void arena_print_stats(const Arena* arena);
+
+#ifdef ARENA_IMPLEMENTATION_
+
+#define ARENA_ROUND(bytes) (((bytes) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static _Thread_local Arena* thread_arena = NULL;
+static atomic_size_t arena_live_arenas;
+static atomic_size_t arena_live_blocks;
+static atomic_size_t arena_live_bytes;
+
+/*********************************************************************
+* static Arena_Block* arena_new_block(Arena* arena, size_t bytes)
+*
+* 	PURPOSE ::
+*  		malloc a block with room for at least <bytes>
+*  			-NULL when the heap is out
+*********************************************************************/
+static Arena_Block* arena_new_block(Arena* arena, size_t bytes)
+{
+	size_t size = (bytes > arena->block_size) ? ARENA_ROUND(bytes) : arena->block_size;
+	Arena_Block* block = (Arena_Block*)aligned_alloc(ARENA_ALIGN,
+			ARENA_ROUND(sizeof(Arena_Block) + size));
+	if(!block)
+		return NULL;
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+
+	arena->stats.blocks++;
+	arena->stats.bytes_reserved += size;
+	atomic_fetch_add(&arena_live_blocks, 1);
+	atomic_fetch_add(&arena_live_bytes, size);
+	return block;
+}
+/*********************************************************************
+* Arena* arena_create(size_t block_size)
+*
+* 	PURPOSE ::
+*  		start an arena that grabs heap memory <block_size>
+*  		bytes at a time
+*
+* 	@param
+*	 - block_size :: 0 for ARENA_DEFAULT_BLOCK, bigger single
+*	 		 allocations get a block of their own
+*
+*	 @return
+*	 - NULL  :: no memory
+*	 - arena :: newly created, with one block ready
+*********************************************************************/
+Arena* arena_create(size_t block_size)
+{
+	Arena* arena = (Arena*)calloc(1, sizeof(Arena));
+	if(!arena)
+		return NULL;
+	arena->block_size = block_size ? ARENA_ROUND(block_size) : ARENA_DEFAULT_BLOCK;
+	arena->first = arena_new_block(arena, arena->block_size);
+	if(!arena->first)
+	{
+		free(arena);
+		return NULL;
+	}
+	arena->current = arena->first;
+	atomic_fetch_add(&arena_live_arenas, 1);
+	return arena;
+}
+/*********************************************************************
+* void arena_destroy(Arena* arena)
+*
+* 	PURPOSE ::
+*  		give every block back to the heap, everything carved
+*  		from <arena> is gone
+*
+* 	@param
+*	 - arena :: arena to free
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void arena_destroy(Arena* arena)
+{
+	if(!arena)
+		return;
+	Arena_Block* block = arena->first;
+	while(block)
+	{
+		Arena_Block* next = block->next;
+		atomic_fetch_sub(&arena_live_blocks, 1);
+		atomic_fetch_sub(&arena_live_bytes, block->size);
+		free(block);
+		block = next;
+	}
+	atomic_fetch_sub(&arena_live_arenas, 1);
+	free(arena);
+	return;
+}
+/*********************************************************************
+* void* arena_alloc(Arena* arena, size_t bytes)
+*
+* 	PURPOSE ::
+*  		carve <bytes> from <arena>, aligned to ARENA_ALIGN
+*  			-reuses blocks kept by an earlier reset before
+*  			asking the heap for another
+*
+* 	@param
+*	 - arena :: arena to carve from
+*	 - bytes :: size wanted
+*
+*	 @return
+*	 - NULL :: no memory
+*	 - ptr  :: valid until the next reset / release past it
+*********************************************************************/
+void* arena_alloc(Arena* arena, size_t bytes)
+{
+	bytes = ARENA_ROUND(bytes ? bytes : 1);
+	Arena_Block* block = arena->current;
+
+	while(block->used + bytes > block->size)
+	{
+		if(!block->next)
+		{
+			Arena_Block* fresh = arena_new_block(arena, bytes);
+			if(!fresh)
+				return NULL;
+			block->next = fresh;
+		}
+		block = block->next;
+		block->used = 0;
+	}
+
+	void* ptr = block->data + block->used;
+	block->used += bytes;
+	arena->current = block;
+	arena->last = ptr;
+
+	arena->stats.allocations++;
+	arena->stats.bytes_in_use += bytes;
+	if(arena->stats.bytes_in_use > arena->stats.peak_bytes)
+		arena->stats.peak_bytes = arena->stats.bytes_in_use;
+	return ptr;
+}
+/*********************************************************************
+* void* arena_alloc_zero(Arena* arena, size_t bytes)
+*
+* 	PURPOSE ::
+*  		arena_alloc() and zero the memory, the calloc of arenas
+*
+* 	@param
+*	 - arena :: arena to carve from
+*	 - bytes :: size wanted
+*
+*	 @return
+*	 - NULL :: no memory
+*	 - ptr  :: zeroed memory
+*********************************************************************/
+void* arena_alloc_zero(Arena* arena, size_t bytes)
+{
+	void* ptr = arena_alloc(arena, bytes);
+	if(ptr)
+		memset(ptr, 0, bytes);
+	return ptr;
+}
+/*********************************************************************
+* void* arena_grow(Arena* arena, void* old, size_t old_bytes,
+*		size_t new_bytes)
+*
+* 	PURPOSE ::
+*  		the realloc of arenas
+*  			-the most recent allocation grows in place when
+*  			its block has room, anything else is copied and
+*  			the old copy stays until the next reset
+*
+* 	@param
+*	 - arena     :: arena <old> came from
+*	 - old       :: allocation to grow, NULL allocates
+*	 - old_bytes :: its current size
+*	 - new_bytes :: size wanted
+*
+*	 @return
+*	 - NULL :: no memory, <old> is untouched
+*	 - ptr  :: holds the first old_bytes of <old>
+*********************************************************************/
+void* arena_grow(Arena* arena, void* old, size_t old_bytes, size_t new_bytes)
+{
+	if(!old)
+		return arena_alloc(arena, new_bytes);
+	if(new_bytes <= old_bytes)
+		return old;
+
+	Arena_Block* block = arena->current;
+	size_t old_rounded = ARENA_ROUND(old_bytes);
+	size_t new_rounded = ARENA_ROUND(new_bytes);
+	if(old == arena->last && block->used - old_rounded + new_rounded <= block->size)
+	{
+		block->used += new_rounded - old_rounded;
+		arena->stats.bytes_in_use += new_rounded - old_rounded;
+		if(arena->stats.bytes_in_use > arena->stats.peak_bytes)
+			arena->stats.peak_bytes = arena->stats.bytes_in_use;
+		return old;
+	}
+
+	void* ptr = arena_alloc(arena, new_bytes);
+	if(ptr)
+		memcpy(ptr, old, old_bytes);
+	return ptr;
+}
+/*********************************************************************
+* void arena_reset(Arena* arena)
+*
+* 	PURPOSE ::
+*  		free everything carved from <arena> at once, e.g.
+*  		between games
+*  			-the blocks are kept, so steady-state use never
+*  			touches the heap again
+*
+* 	@param
+*	 - arena :: arena to empty
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void arena_reset(Arena* arena)
+{
+	arena->current = arena->first;
+	arena->first->used = 0;
+	arena->last = NULL;
+	arena->stats.bytes_in_use = 0;
+	arena->stats.resets++;
+	return;
+}
+/*********************************************************************
+* Arena_Mark arena_mark(const Arena* arena)
+*
+* 	PURPOSE ::
+*  		remember how full <arena> is, for arena_release()
+*
+* 	@param
+*	 - arena :: arena to mark
+*
+*	 @return
+*	 - Arena_Mark :: the current fill point
+*********************************************************************/
+Arena_Mark arena_mark(const Arena* arena)
+{
+	Arena_Mark mark = { arena->current, arena->current->used, arena->stats.bytes_in_use };
+	return mark;
+}
+/*********************************************************************
+* void arena_release(Arena* arena, Arena_Mark mark)
+*
+* 	PURPOSE ::
+*  		free everything carved since <mark>, a scoped reset
+*  		for per-search or per-move scratch
+*
+* 	@param
+*	 - arena :: arena <mark> was taken from
+*	 - mark  :: from arena_mark()
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void arena_release(Arena* arena, Arena_Mark mark)
+{
+	arena->current = mark.block;
+	arena->current->used = mark.used;
+	arena->last = NULL;
+	arena->stats.bytes_in_use = mark.bytes_in_use;
+	return;
+}
+/*********************************************************************
+* void arena_stats(const Arena* arena, Arena_Stats* stats)
+*
+* 	PURPOSE ::
+*  		allocation counts and memory held by <arena>
+*
+* 	@param
+*	 - arena :: arena to inspect
+*	 - stats :: overwritten
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void arena_stats(const Arena* arena, Arena_Stats* stats)
+{
+	*stats = arena->stats;
+	return;
+}
+/*********************************************************************
+* Arena* arena_thread(void)
+*
+* 	PURPOSE ::
+*  		the calling thread's own arena, made on first use
+*  			-no locking anywhere, no other thread sees it
+*  			-call arena_thread_release() before the thread
+*  			exits or its blocks leak
+*
+*	 @return
+*	 - Arena* :: this thread's arena, exits on no memory
+*********************************************************************/
+Arena* arena_thread(void)
+{
+	if(!thread_arena)
+	{
+		thread_arena = arena_create(ARENA_DEFAULT_BLOCK);
+		if(!thread_arena)
+			error_nomem();
+	}
+	return thread_arena;
+}
+/*********************************************************************
+* void arena_thread_release(void)
+*
+* 	PURPOSE ::
+*  		destroy the calling thread's arena, if it made one
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void arena_thread_release(void)
+{
+	arena_destroy(thread_arena);
+	thread_arena = NULL;
+	return;
+}
+/*********************************************************************
+* void arena_global_stats(Arena_Global_Stats* stats)
+*
+* 	PURPOSE ::
+*  		arenas, blocks and bytes alive in the whole process,
+*  		a number that keeps climbing across games is a leak
+*
+* 	@param
+*	 - stats :: overwritten
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void arena_global_stats(Arena_Global_Stats* stats)
+{
+	stats->arenas = atomic_load(&arena_live_arenas);
+	stats->blocks = atomic_load(&arena_live_blocks);
+	stats->bytes_reserved = atomic_load(&arena_live_bytes);
+	return;
+}
+/*********************************************************************
+* void arena_print_stats(const Arena* arena)
+*
+* 	PURPOSE ::
+*  		print the counters of <arena> and the process totals
+*
+* 	@param
+*	 - arena :: arena to report, NULL for the totals only
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void arena_print_stats(const Arena* arena)
+{
+	if(arena)
+		printf("arena    : %llu allocations, %llu resets, %zu bytes in use (peak %zu), "
+				"%zu reserved in %zu blocks\n",
+				arena->stats.allocations, arena->stats.resets, arena->stats.bytes_in_use,
+				arena->stats.peak_bytes, arena->stats.bytes_reserved, arena->stats.blocks);
+
+	Arena_Global_Stats global;
+	arena_global_stats(&global);
+	printf("arenas   : %zu live, %zu blocks, %zu bytes reserved\n",
+			global.arenas, global.blocks, global.bytes_reserved);
+	return;
+}
+#endif //ARENA_IMPLEMENTATION_
+#endif //ARENA_H_
@@ -0,0 +1,134 @@
+#ifndef BATCH_VALIDATE_H_
+#define BATCH_VALIDATE_H_
+
+///user defined
+#include "position.h"
+#include "move_gen.h"
+#include "move_cache.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+//how many recently generated positions a batch keeps around,
+//requests for the same position rarely sit far apart
+#define VALIDATE_LOOKASIDE 8
+
+//verdict i lives in bit (i % 64) of word (i / 64)
+#define VERDICT_WORDS(count) (((count) + 63) / 64)
+#define VERDICT_GET(verdicts, i) (((verdicts)[(i) / 64] >> ((i) % 64)) & 1ULL)
+
+typedef struct Validate_Request
+{
+	const Position* position;
+	Move move;
+} Validate_Request;
+
+size_t validate_batch(const Validate_Request* requests, size_t count,
+		unsigned long long* verdicts);
+size_t validate_batch_cached(Move_Cache* cache, const Validate_Request* requests,
+		size_t count, unsigned long long* verdicts);
+
+#ifdef BATCH_VALIDATE_IMPLEMENTATION_
+
+/*********************************************************************
+* size_t validate_batch(const Validate_Request* requests, size_t count,
+*		unsigned long long* verdicts)
+*
+* 	PURPOSE ::
+*  		answer "is this move legal" for a whole batch of
+*  		(position, move) pairs
+*  			-each distinct position is generated once, every
+*  			move against it is then a single bit test
+*  			-requests are best grouped by position, only the
+*  			last VALIDATE_LOOKASIDE positions are remembered
+*
+* 	@param
+*	 - requests :: <count> (position, move) pairs
+*	 - count    :: batch size
+*	 - verdicts :: VERDICT_WORDS(<count>) words, bit i is set
+*	 	       when request i is legal
+*
+*	 @return
+*	 - size_t :: number of legal moves in the batch
+*********************************************************************/
+size_t validate_batch(const Validate_Request* requests, size_t count,
+		unsigned long long* verdicts)
+{
+	return validate_batch_cached(NULL, requests, count, verdicts);
+}
+/*********************************************************************
+* size_t validate_batch_cached(Move_Cache* cache,
+*		const Validate_Request* requests, size_t count,
+*		unsigned long long* verdicts)
+*
+* 	PURPOSE ::
+*  		validate_batch(), but positions missing from the
+*  		lookaside are fetched through <cache> before
+*  		falling back to generation
+*
+* 	@param
+*	 - cache    :: shared legal-move cache, NULL to always generate
+*	 - requests :: <count> (position, move) pairs
+*	 - count    :: batch size
+*	 - verdicts :: VERDICT_WORDS(<count>) words, bit i is set
+*	 	       when request i is legal
+*
+*	 @return
+*	 - size_t :: number of legal moves in the batch
+*********************************************************************/
+size_t validate_batch_cached(Move_Cache* cache, const Validate_Request* requests,
+		size_t count, unsigned long long* verdicts)
+{
+	if(!requests || !verdicts)
+	{
+		error_noexist("requests", "validate_batch_cached");
+		return 0;
+	}
+
+	//4KB of sets on the stack, a batch allocates nothing
+	Move_Set sets[VALIDATE_LOOKASIDE];
+	const Position* owners[VALIDATE_LOOKASIDE] = { NULL };
+	size_t next_slot = 0;
+	size_t last = 0;
+	size_t legal = 0;
+
+	memset(verdicts, 0, VERDICT_WORDS(count) * sizeof(unsigned long long));
+
+	for(size_t i = 0; i < count; ++i)
+	{
+		const Position* pos = requests[i].position;
+		if(!pos)
+			continue;
+
+		//most batches repeat the position of the previous request
+		if(owners[last] != pos)
+		{
+			size_t slot = 0;
+			while(slot < VALIDATE_LOOKASIDE && owners[slot] != pos)
+				slot++;
+			if(slot == VALIDATE_LOOKASIDE)
+			{
+				slot = next_slot;
+				next_slot = (next_slot + 1) % VALIDATE_LOOKASIDE;
+				if(cache)
+					move_cache_generate(cache, pos, &sets[slot]);
+				else
+					generate_moves(pos, &sets[slot]);
+				owners[slot] = pos;
+			}
+			last = slot;
+		}
+
+		if(move_set_contains(&sets[last], requests[i].move))
+		{
+			verdicts[i / 64] |= 1ULL << (i % 64);
+			legal++;
+		}
+	}
+
+	return legal;
+}
+#endif //BATCH_VALIDATE_IMPLEMENTATION_
+#endif //BATCH_VALIDATE_H_
@@ -6,8 +6,10 @@
 #include <math.h>
 #include <assert.h>
 #include <ctype.h>
+#include <string.h>
 
 #include "util.h"
+#include "arena.h"
 
 #define NUM_ROWS 8
 #define NUM_COLS 8
@@ -16,6 +18,7 @@
 
 void cleanup(char** board, size_t row);
 char** init_board(void);
+char** init_board_arena(Arena* arena);
 void set_piece(char** board, short row, short col, char piece);
 char get_piece(char** board, short row, short col);
 void draw_board(char** board);
@@ -26,27 +29,50 @@ void draw_board(char** board);
 * void cleanup(char** board, size_t row)
 *
 * 	PURPOSE ::
-*  		free the memory allocated for the board and its row 
-*  			-needs to free each row individually, 
-*     			(pointer to pointers)
+*  		free the memory allocated for the board and its rows
+*  			-init_board() hands out the row pointers and
+*  			the squares as one block, so freeing <board>
+*  			frees every row with it
+*  			-boards from init_board_arena() belong to the
+*  			arena, never cleanup() those
 * 	@param 
-*	 - board :: 2d character array
-*	 - row   :: the row to start deallocating at 
-*	    	    (in case of error in init)
+*	 - board :: 2d character array from init_board()
+*	 - row   :: rows initialised so far, every row lives in
+*	    	    the same block so nothing depends on it
 *	 @return
 *	 - void :: no need to return anything
 *********************************************************************/
 void cleanup(char** board, size_t row)
 {
-	for (size_t i = 0; i < row; ++i)
-	{
-		board[i] = NULL;
-		free(board[i]);
-	}
-	board = NULL;
+	(void)row;
 	free(board);
 	return;
 }
+/*********************************************************************
+* static void board_fill(char** board, char* squares)
+*
+* 	PURPOSE ::
+*  		point the row pointers of <board> into <squares> and
+*  		lay the starting position out there
+*********************************************************************/
+static void board_fill(char** board, char* squares)
+{
+	const char init_board[8][8] = {
+		{'r', 'n', 'b', 'q', 'k', 'b', 'n', 'r' },
+		{'p', 'p', 'p', 'p', 'p', 'p', 'p', 'p' }, 
+		{'.', '.', '.', '.', '.', '.', '.', '.' },
+		{'.', '.', '.', '.', '.', '.', '.', '.' },
+		{'.', '.', '.', '.', '.', '.', '.', '.' },
+		{'.', '.', '.', '.', '.', '.', '.', '.' },
+		{'P', 'P', 'P', 'P', 'P', 'P', 'P', 'P' }, 
+		{'R', 'N', 'B', 'Q', 'K', 'B', 'N', 'R' }
+	};
+
+	memcpy(squares, init_board, sizeof(init_board));
+	for(size_t row = 0; row < NUM_ROWS; ++row)
+		board[row] = squares + row * NUM_COLS;
+	return;
+}
 
 /*********************************************************************
 * char** init_board(void)
@@ -57,44 +83,42 @@ void cleanup(char** board, size_t row)
 *		Lowercase pieces will represent the "black" pieces,
 *		Uppercase pieces will represent the "white" pieces.
 *     			(pointer to pointers)
+*		- the row pointers and all 64 squares come from
+*		one malloc, cleanup() frees it
 * 	@param 
-*	 - board :: 2d character array
-*	 - row   :: the row to start deallocating at 
-*	    	    (in case of error in init)
+*	 - void :: no parameters
 *	 @return
-*	 - void :: no need to return anything
+*	 - board :: newly created board, exits on no memory
 *********************************************************************/
 char** init_board(void)
 {
-	char **board = (char**)malloc(NUM_ROWS * sizeof(char*));	
+	char **board = (char**)malloc(NUM_ROWS * sizeof(char*) + NUM_ROWS * NUM_COLS);
 	if(!board)
-	{
-		cleanup(board, 0);
 		error_nomem();
-	}
 
-	const char init_board[8][8] = {
-		{'r', 'n', 'b', 'q', 'k', 'b', 'n', 'r' },
-		{'p', 'p', 'p', 'p', 'p', 'p', 'p', 'p' }, 
-		{'.', '.', '.', '.', '.', '.', '.', '.' },
-		{'.', '.', '.', '.', '.', '.', '.', '.' },
-		{'.', '.', '.', '.', '.', '.', '.', '.' },
-		{'.', '.', '.', '.', '.', '.', '.', '.' },
-		{'P', 'P', 'P', 'P', 'P', 'P', 'P', 'P' }, 
-		{'R', 'N', 'B', 'Q', 'K', 'B', 'N', 'R' }
-	};
+	board_fill(board, (char*)(board + NUM_ROWS));
+	return board;
+}
+/*********************************************************************
+* char** init_board_arena(Arena* arena)
+*
+*   	PURPOSE ::
+*		- init_board(), carved from <arena> instead of the
+*		heap, so a game's boards go away with one
+*		arena_reset()
+* 	@param 
+*	 - arena :: arena to carve from, e.g. arena_thread()
+*	 @return
+*	 - NULL  :: the arena could not grow
+*	 - board :: starting position, owned by <arena>
+*********************************************************************/
+char** init_board_arena(Arena* arena)
+{
+	char **board = (char**)arena_alloc(arena, NUM_ROWS * sizeof(char*) + NUM_ROWS * NUM_COLS);
+	if(!board)
+		return NULL;
 
-	for(size_t row = 0; row < NUM_ROWS; ++row)
-	{
-  board[row] = (char*) malloc(NUM_COLS * sizeof(char));
-		if(!board[row])
-		{
-			cleanup(board, row);
-			error_nomem();
-		}
-		for(size_t col = 0; col < NUM_COLS; ++col)
-			board[row][col] = init_board[row][col];
-	}
+	board_fill(board, (char*)(board + NUM_ROWS));
 	return board;
 }
 /*********************************************************************
@@ -118,7 +142,10 @@ char** init_board(void)
 void set_piece(char** board, short row, short col, char piece)
 {
   if(!board)
-		  ERR_NOEXIST(board, "set_piece");
+	{
+		error_noexist("board", "set_piece");
+		return;
+	}
 		
 		board[row][col] = piece;
 		return;
@@ -142,7 +169,10 @@ void set_piece(char** board, short row, short col, char piece)
 char get_piece(char** board, short row, short col)
 {
   if(!board)
-		  ERR_NOEXIST(board, "get_piece");
+	{
+		error_noexist("board", "get_piece");
+		return '\0';
+	}
 		return board[row][col];
 }
 /*********************************************************************
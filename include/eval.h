@@ -0,0 +1,307 @@
+#ifndef EVAL_H_
+#define EVAL_H_
+
+///user defined
+#include "position.h"
+#include "stats.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#define NUM_PIECE_KINDS 6	//P N B R Q K
+#define EVAL_NUM_PARAMS (NUM_PIECE_KINDS + NUM_PIECE_KINDS * NUM_ROWS * NUM_COLS)
+//weights the engine picks up at startup when the file exists
+#define EVAL_PARAMS_FILE "eval.params"
+
+//the evaluation is linear in these : every piece adds its material
+//and the square table entry for where it stands.
+//tables are written from white's side, row 0 is the far row,
+//black pieces read them mirrored
+typedef struct Eval_Params
+{
+	int material[NUM_PIECE_KINDS];
+	int pst[NUM_PIECE_KINDS][NUM_ROWS * NUM_COLS];
+} Eval_Params;
+
+extern Eval_Params eval_params;
+
+int piece_kind(char piece);
+int evaluate(const Position* pos);
+int evaluate_with(const Eval_Params* params, const Position* pos);
+short eval_load_params(const char* path, Eval_Params* params);
+short eval_save_params(const char* path, const Eval_Params* params);
+
+#ifdef EVAL_IMPLEMENTATION_
+
+static const char* const piece_kind_names[NUM_PIECE_KINDS] = {
+	"pawn", "knight", "bishop", "rook", "queen", "king"
+};
+
+Eval_Params eval_params = {
+	.material = { 100, 320, 330, 500, 900, 0 },
+	.pst = {
+		{ //pawn
+			  0,  0,  0,  0,  0,  0,  0,  0,
+			 50, 50, 50, 50, 50, 50, 50, 50,
+			 10, 10, 20, 30, 30, 20, 10, 10,
+			  5,  5, 10, 25, 25, 10,  5,  5,
+			  0,  0,  0, 20, 20,  0,  0,  0,
+			  5, -5,-10,  0,  0,-10, -5,  5,
+			  5, 10, 10,-20,-20, 10, 10,  5,
+			  0,  0,  0,  0,  0,  0,  0,  0
+		},
+		{ //knight
+			-50,-40,-30,-30,-30,-30,-40,-50,
+			-40,-20,  0,  0,  0,  0,-20,-40,
+			-30,  0, 10, 15, 15, 10,  0,-30,
+			-30,  5, 15, 20, 20, 15,  5,-30,
+			-30,  0, 15, 20, 20, 15,  0,-30,
+			-30,  5, 10, 15, 15, 10,  5,-30,
+			-40,-20,  0,  5,  5,  0,-20,-40,
+			-50,-40,-30,-30,-30,-30,-40,-50
+		},
+		{ //bishop
+			-20,-10,-10,-10,-10,-10,-10,-20,
+			-10,  0,  0,  0,  0,  0,  0,-10,
+			-10,  0,  5, 10, 10,  5,  0,-10,
+			-10,  5,  5, 10, 10,  5,  5,-10,
+			-10,  0, 10, 10, 10, 10,  0,-10,
+			-10, 10, 10, 10, 10, 10, 10,-10,
+			-10,  5,  0,  0,  0,  0,  5,-10,
+			-20,-10,-10,-10,-10,-10,-10,-20
+		},
+		{ //rook
+			  0,  0,  0,  0,  0,  0,  0,  0,
+			  5, 10, 10, 10, 10, 10, 10,  5,
+			 -5,  0,  0,  0,  0,  0,  0, -5,
+			 -5,  0,  0,  0,  0,  0,  0, -5,
+			 -5,  0,  0,  0,  0,  0,  0, -5,
+			 -5,  0,  0,  0,  0,  0,  0, -5,
+			 -5,  0,  0,  0,  0,  0,  0, -5,
+			  0,  0,  0,  5,  5,  0,  0,  0
+		},
+		{ //queen
+			-20,-10,-10, -5, -5,-10,-10,-20,
+			-10,  0,  0,  0,  0,  0,  0,-10,
+			-10,  0,  5,  5,  5,  5,  0,-10,
+			 -5,  0,  5,  5,  5,  5,  0, -5,
+			  0,  0,  5,  5,  5,  5,  0, -5,
+			-10,  5,  5,  5,  5,  5,  0,-10,
+			-10,  0,  5,  0,  0,  0,  0,-10,
+			-20,-10,-10, -5, -5,-10,-10,-20
+		},
+		{ //king
+			-30,-40,-40,-50,-50,-40,-40,-30,
+			-30,-40,-40,-50,-50,-40,-40,-30,
+			-30,-40,-40,-50,-50,-40,-40,-30,
+			-30,-40,-40,-50,-50,-40,-40,-30,
+			-20,-30,-30,-40,-40,-30,-30,-20,
+			-10,-20,-20,-20,-20,-20,-20,-10,
+			 20, 20,  0,  0,  0,  0, 20, 20,
+			 20, 30, 10,  0,  0, 10, 30, 20
+		}
+	}
+};
+
+/*********************************************************************
+* int piece_kind(char piece)
+*
+* 	PURPOSE ::
+*  		map a piece letter of either colour to 0..5 (P N B R Q K)
+*
+* 	@param
+*	 - piece :: piece letter
+*
+*	 @return
+*	 - FAILURE :: not a piece
+*	 - kind    :: 0 .. NUM_PIECE_KINDS - 1
+*********************************************************************/
+int piece_kind(char piece)
+{
+	switch(tolower(piece))
+	{
+		case 'p': return 0;
+		case 'n': return 1;
+		case 'b': return 2;
+		case 'r': return 3;
+		case 'q': return 4;
+		case 'k': return 5;
+		default:  return FAILURE;
+	}
+}
+/*********************************************************************
+* int evaluate_with(const Eval_Params* params, const Position* pos)
+*
+* 	PURPOSE ::
+*  		score <pos> with <params>
+*
+* 	@param
+*	 - params :: weights to use
+*	 - pos    :: the position to score
+*
+*	 @return
+*	 - int :: centipawns, positive when the side to move is better
+*********************************************************************/
+int evaluate_with(const Eval_Params* params, const Position* pos)
+{
+	STAT_INC(STAT_EVAL_CALLS);
+	STAT_TIMER(TIMER_EVAL);
+	int score = 0;
+	for(size_t row = 0; row < NUM_ROWS; ++row)
+		for(size_t col = 0; col < NUM_COLS; ++col)
+		{
+			char piece = pos->squares[row][col];
+			int kind = piece_kind(piece);
+			if(kind == FAILURE)
+				continue;
+			if(isupper(piece))
+				score += params->material[kind] + params->pst[kind][row * NUM_COLS + col];
+			else
+				score -= params->material[kind] + params->pst[kind][(NUM_ROWS - 1 - row) * NUM_COLS + col];
+		}
+	return (pos->side == WHITE) ? score : -score;
+}
+/*********************************************************************
+* int evaluate(const Position* pos)
+*
+* 	PURPOSE ::
+*  		score <pos> with the engine's current weights
+*
+* 	@param
+*	 - pos :: the position to score
+*
+*	 @return
+*	 - int :: centipawns, positive when the side to move is better
+*********************************************************************/
+int evaluate(const Position* pos)
+{
+	return evaluate_with(&eval_params, pos);
+}
+/*********************************************************************
+* short eval_load_params(const char* path, Eval_Params* params)
+*
+* 	PURPOSE ::
+*  		read weights written by eval_save_params()
+*  			-'#' starts a comment, blank lines are skipped
+*  			-"material" takes NUM_PIECE_KINDS values,
+*  			"pst <piece>" takes NUM_ROWS * NUM_COLS values
+*  			-sections not in the file keep their old values
+*
+* 	@param
+*	 - path   :: parameter file
+*	 - params :: updated only if the whole file parses
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: missing or malformed file
+*********************************************************************/
+short eval_load_params(const char* path, Eval_Params* params)
+{
+	if(!path || !params)
+	{
+		error_noexist("path", "eval_load_params");
+		return FAILURE;
+	}
+	FILE* file = fopen(path, "r");
+	if(!file)
+		return FAILURE;
+
+	Eval_Params loaded = *params;
+	char word[32];
+	short status = 0;
+	while(status == 0 && fscanf(file, " %31s", word) == 1)
+	{
+		if(word[0] == '#')
+		{
+			int c;
+			while((c = fgetc(file)) != EOF && c != '\n')
+				;
+			continue;
+		}
+
+		int* values = NULL;
+		size_t count = 0;
+		if(strcmp(word, "material") == 0)
+		{
+			values = loaded.material;
+			count = NUM_PIECE_KINDS;
+		}
+		else if(strcmp(word, "pst") == 0 && fscanf(file, " %31s", word) == 1)
+		{
+			for(size_t kind = 0; kind < NUM_PIECE_KINDS; ++kind)
+				if(strcmp(word, piece_kind_names[kind]) == 0)
+					values = loaded.pst[kind];
+			count = NUM_ROWS * NUM_COLS;
+		}
+
+		if(!values)
+			status = FAILURE;
+		for(size_t i = 0; values && i < count; ++i)
+			if(fscanf(file, " %d", &values[i]) != 1)
+			{
+				status = FAILURE;
+				break;
+			}
+	}
+	fclose(file);
+
+	if(status != 0)
+	{
+		fprintf(stderr, "Malformed parameter file %s\n", path);
+		return FAILURE;
+	}
+	*params = loaded;
+	return 0;
+}
+/*********************************************************************
+* short eval_save_params(const char* path, const Eval_Params* params)
+*
+* 	PURPOSE ::
+*  		write <params> in the text form eval_load_params()
+*  		reads, square tables laid out as the board
+*
+* 	@param
+*	 - path   :: file to (over)write
+*	 - params :: weights to save
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: could not write <path>
+*********************************************************************/
+short eval_save_params(const char* path, const Eval_Params* params)
+{
+	FILE* file = fopen(path, "w");
+	if(!file)
+	{
+		perror("Could not write parameter file\n\t{eval_save_params}\n");
+		return FAILURE;
+	}
+
+	fprintf(file, "# P N B R Q K\nmaterial");
+	for(size_t kind = 0; kind < NUM_PIECE_KINDS; ++kind)
+		fprintf(file, " %d", params->material[kind]);
+	fprintf(file, "\n");
+
+	for(size_t kind = 0; kind < NUM_PIECE_KINDS; ++kind)
+	{
+		fprintf(file, "\npst %s\n", piece_kind_names[kind]);
+		for(size_t row = 0; row < NUM_ROWS; ++row)
+		{
+			for(size_t col = 0; col < NUM_COLS; ++col)
+				fprintf(file, "%5d", params->pst[kind][row * NUM_COLS + col]);
+			fprintf(file, "\n");
+		}
+	}
+
+	short status = ferror(file) ? FAILURE : 0;
+	if(fclose(file) != 0)
+		status = FAILURE;
+	if(status != 0)
+		perror("Could not write parameter file\n\t{eval_save_params}\n");
+	return status;
+}
+#endif //EVAL_IMPLEMENTATION_
+#endif //EVAL_H_
@@ -0,0 +1,201 @@
+#ifndef FEN_H_
+#define FEN_H_
+
+///user defined
+#include "position.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+//longest FEN this engine ever writes, terminator included
+#define FEN_MAX 96
+
+short position_from_fen(Position* pos, const char* fen);
+short position_to_fen(const Position* pos, char* fen, size_t size);
+short move_from_coord(const char* coord, Move* move);
+void move_to_coord(Move move, char coord[6]);
+
+#ifdef FEN_IMPLEMENTATION_
+
+/*********************************************************************
+* short position_from_fen(Position* pos, const char* fen)
+*
+* 	PURPOSE ::
+*  		read a FEN string into <pos>
+*  			-castling and en passant fields are accepted and
+*  			ignored, the rules do not know either move
+*  			-missing move clocks default to 0 and 1
+*
+* 	@param
+*	 - pos :: overwritten on success, untouched on failure
+*	 - fen :: e.g. "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1"
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: malformed FEN
+*********************************************************************/
+short position_from_fen(Position* pos, const char* fen)
+{
+	if(!pos || !fen)
+	{
+		error_noexist("fen", "position_from_fen");
+		return FAILURE;
+	}
+
+	Position parsed;
+	memset(parsed.squares, '.', sizeof(parsed.squares));
+	short row = 0;
+	short col = 0;
+	const char* c = fen;
+
+	for(; *c && *c != ' '; ++c)
+	{
+		if(*c == '/')
+		{
+			if(col != NUM_COLS || ++row >= NUM_ROWS)
+				return FAILURE;
+			col = 0;
+		}
+		else if(*c >= '1' && *c <= '8')
+		{
+			col += *c - '0';
+			if(col > NUM_COLS)
+				return FAILURE;
+		}
+		else if(strchr("PNBRQKpnbrqk", *c))
+		{
+			if(col >= NUM_COLS)
+				return FAILURE;
+			parsed.squares[row][col++] = *c;
+		}
+		else
+			return FAILURE;
+	}
+	if(row != NUM_ROWS - 1 || col != NUM_COLS)
+		return FAILURE;
+
+	while(*c == ' ')
+		++c;
+	if(*c != WHITE && *c != BLACK)
+		return FAILURE;
+	parsed.side = *c++;
+
+	//castling and en passant, skipped
+	char castling[8] = "-";
+	char en_passant[4] = "-";
+	unsigned halfmove = 0;
+	unsigned fullmove = 1;
+	sscanf(c, " %7s %3s %u %u", castling, en_passant, &halfmove, &fullmove);
+
+	parsed.halfmove = (unsigned short)halfmove;
+	parsed.fullmove = (unsigned short)(fullmove ? fullmove : 1);
+	*pos = parsed;
+	return 0;
+}
+/*********************************************************************
+* short position_to_fen(const Position* pos, char* fen, size_t size)
+*
+* 	PURPOSE ::
+*  		write <pos> out as a FEN string
+*
+* 	@param
+*	 - pos  :: the position to write
+*	 - fen  :: receives the string
+*	 - size :: room in <fen>, FEN_MAX is always enough
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: <fen> is too small
+*********************************************************************/
+short position_to_fen(const Position* pos, char* fen, size_t size)
+{
+	char buffer[FEN_MAX];
+	size_t len = 0;
+
+	for(size_t row = 0; row < NUM_ROWS; ++row)
+	{
+		short empty = 0;
+		for(size_t col = 0; col < NUM_COLS; ++col)
+		{
+			char piece = pos->squares[row][col];
+			if(piece == '.')
+			{
+				empty++;
+				continue;
+			}
+			if(empty)
+				buffer[len++] = (char)('0' + empty);
+			empty = 0;
+			buffer[len++] = piece;
+		}
+		if(empty)
+			buffer[len++] = (char)('0' + empty);
+		if(row < NUM_ROWS - 1)
+			buffer[len++] = '/';
+	}
+
+	int written = snprintf(buffer + len, sizeof(buffer) - len, " %c - - %u %u",
+			pos->side, pos->halfmove, pos->fullmove);
+	len += (size_t)written;
+	if(len + 1 > size)
+		return FAILURE;
+
+	memcpy(fen, buffer, len + 1);
+	return 0;
+}
+/*********************************************************************
+* short move_from_coord(const char* coord, Move* move)
+*
+* 	PURPOSE ::
+*  		read a move in coordinate notation ("e2e4"),
+*  		files a..h are cols 0..7, rank 8 is row 0
+*
+* 	@param
+*	 - coord :: at least four characters
+*	 - move  :: overwritten on success
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: not a move
+*********************************************************************/
+short move_from_coord(const char* coord, Move* move)
+{
+	if(!coord || strlen(coord) < 4)
+		return FAILURE;
+	for(size_t i = 0; i < 4; i += 2)
+		if(coord[i] < 'a' || coord[i] > 'h' || coord[i + 1] < '1' || coord[i + 1] > '8')
+			return FAILURE;
+
+	move->origin[0] = (short)(NUM_ROWS - (coord[1] - '0'));
+	move->origin[1] = (short)(coord[0] - 'a');
+	move->dest[0]   = (short)(NUM_ROWS - (coord[3] - '0'));
+	move->dest[1]   = (short)(coord[2] - 'a');
+	return 0;
+}
+/*********************************************************************
+* void move_to_coord(Move move, char coord[6])
+*
+* 	PURPOSE ::
+*  		write <move> in coordinate notation ("e2e4")
+*
+* 	@param
+*	 - move  :: an on-board move
+*	 - coord :: receives the string, terminator included
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void move_to_coord(Move move, char coord[6])
+{
+	coord[0] = (char)('a' + move.origin[1]);
+	coord[1] = (char)('0' + NUM_ROWS - move.origin[0]);
+	coord[2] = (char)('a' + move.dest[1]);
+	coord[3] = (char)('0' + NUM_ROWS - move.dest[0]);
+	coord[4] = '\0';
+	return;
+}
+#endif //FEN_IMPLEMENTATION_
+#endif //FEN_H_
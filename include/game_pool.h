@@ -0,0 +1,543 @@
+#ifndef GAME_POOL_H_
+#define GAME_POOL_H_
+
+///user defined
+#include "position.h"
+#include "ring_queue.h"
+#include "latency.h"
+#include "stats.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+//how many requests a shard can have in flight before submit waits
+#define SHARD_QUEUE_SIZE 4096
+//how many empty polls a worker spins through before it naps
+#define WORKER_SPIN_LIMIT 256
+
+typedef enum Move_Verdict
+{
+	MOVE_NO_GAME = -1,	//bad game id, or the game is already over
+	MOVE_ILLEGAL = 0,
+	MOVE_APPLIED = 1
+} Move_Verdict;
+
+typedef struct Move_Request
+{
+	size_t game;
+	Move move;
+} Move_Request;
+
+typedef struct Move_Result
+{
+	short verdict;		//Move_Verdict
+	short status;		//Game_Status after the move
+} Move_Result;
+
+//what actually travels through a shard queue
+typedef struct Pool_Job
+{
+	Move_Request request;
+	Move_Result* result;
+	unsigned long long submitted_ns;
+} Pool_Job;
+
+//one worker thread and everything only it touches
+typedef struct Pool_Shard
+{
+	Ring_Queue queue;
+	pthread_t thread;
+	struct Game_Pool* pool;
+
+	unsigned long long applied;
+	unsigned long long rejected;
+	unsigned long long last_done_ns;
+	Latency_Histogram latency;
+} Pool_Shard;
+
+//games live in one contiguous slab, game i belongs to shard i % num_shards,
+//so a game is only ever touched by one worker and needs no lock
+typedef struct Game_Pool
+{
+	Position* positions;
+	unsigned char* status;
+	unsigned int* plies;
+	size_t capacity;
+	atomic_size_t reserved;		//slots handed out, maybe still being set up
+	atomic_size_t num_games;	//slots set up, ids below this are valid
+
+	Pool_Shard* shards;
+	size_t num_shards;
+
+	atomic_size_t pending;
+	atomic_int running;
+	unsigned long long start_ns;
+} Game_Pool;
+
+typedef struct Pool_Stats
+{
+	unsigned long long moves;
+	unsigned long long applied;
+	unsigned long long rejected;
+	double seconds;
+	double moves_per_second;
+	unsigned long long p50_ns;
+	unsigned long long p99_ns;
+	unsigned long long max_ns;
+} Pool_Stats;
+
+Game_Pool* game_pool_create(size_t capacity, size_t num_threads);
+void game_pool_destroy(Game_Pool* pool);
+long game_pool_new_game(Game_Pool* pool);
+short game_pool_reset_game(Game_Pool* pool, size_t game);
+size_t game_pool_submit(Game_Pool* pool, const Move_Request* requests,
+		Move_Result* results, size_t count);
+void game_pool_wait(Game_Pool* pool);
+void game_pool_stats(Game_Pool* pool, Pool_Stats* stats);
+void game_pool_reset_stats(Game_Pool* pool);
+void game_pool_print_stats(Game_Pool* pool);
+
+#ifdef GAME_POOL_IMPLEMENTATION_
+
+/*********************************************************************
+* static Move_Verdict pool_play(Game_Pool* pool, const Pool_Job* job)
+*
+* 	PURPOSE ::
+*  		validate, apply and adjudicate one move
+*  			-only ever called by the shard owning the game
+*
+* 	@param
+*	 - pool :: the pool the game lives in
+*	 - job  :: request plus where to put the answer
+*
+*	 @return
+*	 - Move_Verdict :: what happened to the move
+*********************************************************************/
+static Move_Verdict pool_play(Game_Pool* pool, const Pool_Job* job)
+{
+	size_t game = job->request.game;
+	Position* pos = &pool->positions[game];
+
+	Move_Verdict verdict = MOVE_ILLEGAL;
+	if(pool->status[game] != GAME_ONGOING)
+		verdict = MOVE_NO_GAME;
+	else if(position_is_move_legal(pos, job->request.move) == TRUE)
+	{
+		position_make_move(pos, job->request.move);
+		pool->plies[game]++;
+		pool->status[game] = (unsigned char)position_status(pos);
+		verdict = MOVE_APPLIED;
+	}
+
+	if(job->result)
+	{
+		job->result->verdict = (short)verdict;
+		job->result->status = (short)pool->status[game];
+	}
+	return verdict;
+}
+/*********************************************************************
+* static void* pool_worker(void* arg)
+*
+* 	PURPOSE ::
+*  		drain one shard's queue until the pool shuts down
+*  			-spins while busy, naps once idle so an empty
+*  			server does not burn every core
+*
+* 	@param
+*	 - arg :: the Pool_Shard this thread owns
+*
+*	 @return
+*	 - NULL :: always
+*********************************************************************/
+static void* pool_worker(void* arg)
+{
+	Pool_Shard* shard = (Pool_Shard*)arg;
+	Game_Pool* pool = shard->pool;
+	Pool_Job job;
+	size_t idle = 0;
+	stats_register_thread();
+
+	while(atomic_load_explicit(&pool->running, memory_order_acquire))
+	{
+		if(ring_queue_pop(&shard->queue, &job) != TRUE)
+		{
+			if(++idle < WORKER_SPIN_LIMIT)
+				sched_yield();
+			else
+			{
+				struct timespec nap = { 0, 50000 };
+				nanosleep(&nap, NULL);
+			}
+			continue;
+		}
+		idle = 0;
+
+		if(pool_play(pool, &job) == MOVE_APPLIED)
+			shard->applied++;
+		else
+			shard->rejected++;
+
+		unsigned long long done = time_now_ns();
+		latency_record(&shard->latency, done - job.submitted_ns);
+		shard->last_done_ns = done;
+		atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_release);
+	}
+	stats_unregister_thread();
+	return NULL;
+}
+/*********************************************************************
+* Game_Pool* game_pool_create(size_t capacity, size_t num_threads)
+*
+* 	PURPOSE ::
+*  		allocate room for <capacity> games and start one
+*  		worker per shard
+*
+* 	@param
+*	 - capacity    :: most games the pool will ever host
+*	 - num_threads :: worker / shard count, 0 picks one per core
+*
+*	 @return
+*	 - NULL :: on failure
+*	 - pool :: newly created pool on success
+*********************************************************************/
+Game_Pool* game_pool_create(size_t capacity, size_t num_threads)
+{
+	if(capacity < 1)
+	{
+		fprintf(stderr, "Capacity must be non-zero!\n");
+		return NULL;
+	}
+	if(num_threads == 0)
+	{
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		num_threads = (cores > 0) ? (size_t)cores : 1;
+	}
+
+	Game_Pool* pool = (Game_Pool*)calloc(1, sizeof(Game_Pool));
+	if(!pool)
+		return NULL;
+
+	pool->capacity = capacity;
+	pool->num_shards = num_threads;
+	pool->positions = (Position*)malloc(capacity * sizeof(Position));
+	pool->status = (unsigned char*)calloc(capacity, sizeof(unsigned char));
+	pool->plies = (unsigned int*)calloc(capacity, sizeof(unsigned int));
+	pool->shards = (Pool_Shard*)aligned_alloc(CACHE_LINE, num_threads * sizeof(Pool_Shard));
+	if(!pool->positions || !pool->status || !pool->plies || !pool->shards)
+	{
+		free(pool->positions);
+		free(pool->status);
+		free(pool->plies);
+		free(pool->shards);
+		free(pool);
+		return NULL;
+	}
+	memset(pool->shards, 0, num_threads * sizeof(Pool_Shard));
+
+	atomic_init(&pool->reserved, 0);
+	atomic_init(&pool->num_games, 0);
+	atomic_init(&pool->pending, 0);
+	atomic_init(&pool->running, TRUE);
+	pool->start_ns = time_now_ns();
+
+	for(size_t i = 0; i < num_threads; ++i)
+	{
+		Pool_Shard* shard = &pool->shards[i];
+		shard->pool = pool;
+		if(ring_queue_init(&shard->queue, SHARD_QUEUE_SIZE, sizeof(Pool_Job)) != 0 ||
+		   pthread_create(&shard->thread, NULL, pool_worker, shard) != 0)
+		{
+			//only the shards before this one have threads to join
+			pool->num_shards = i;
+			ring_queue_free(&shard->queue);
+			game_pool_destroy(pool);
+			return NULL;
+		}
+	}
+	return pool;
+}
+/*********************************************************************
+* void game_pool_destroy(Game_Pool* pool)
+*
+* 	PURPOSE ::
+*  		stop the workers and free everything the pool owns
+*  			-moves still queued are dropped, call
+*  			game_pool_wait() first to finish them
+*
+* 	@param
+*	 - pool :: pool to tear down
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void game_pool_destroy(Game_Pool* pool)
+{
+	if(!pool)
+		return;
+
+	atomic_store_explicit(&pool->running, FALSE, memory_order_release);
+	for(size_t i = 0; i < pool->num_shards; ++i)
+	{
+		pthread_join(pool->shards[i].thread, NULL);
+		ring_queue_free(&pool->shards[i].queue);
+	}
+
+	free(pool->positions);
+	free(pool->status);
+	free(pool->plies);
+	free(pool->shards);
+	free(pool);
+	return;
+}
+/*********************************************************************
+* long game_pool_new_game(Game_Pool* pool)
+*
+* 	PURPOSE ::
+*  		hand out the next free slot, set to the starting position
+*  			-the slot is reserved, set up, then published,
+*  			so a submit racing this call never sees an id
+*  			whose position is not there yet
+*  			-ids are published in order, a caller waits for
+*  			the ones reserved before it to finish
+*
+* 	@param
+*	 - pool :: pool to take the slot from
+*
+*	 @return
+*	 - FAILURE :: pool is full
+*	 - game    :: id to put in Move_Request.game
+*********************************************************************/
+long game_pool_new_game(Game_Pool* pool)
+{
+	if(!pool)
+	{
+		error_noexist("pool", "game_pool_new_game");
+		return FAILURE;
+	}
+
+	size_t game = atomic_fetch_add(&pool->reserved, 1);
+	if(game >= pool->capacity)
+	{
+		atomic_fetch_sub(&pool->reserved, 1);
+		return FAILURE;
+	}
+
+	position_init(&pool->positions[game]);
+	pool->status[game] = GAME_ONGOING;
+	pool->plies[game] = 0;
+
+	while(atomic_load_explicit(&pool->num_games, memory_order_acquire) != game)
+		sched_yield();
+	atomic_store_explicit(&pool->num_games, game + 1, memory_order_release);
+	return (long)game;
+}
+/*********************************************************************
+* short game_pool_reset_game(Game_Pool* pool, size_t game)
+*
+* 	PURPOSE ::
+*  		put <game> back to the starting position so its slot
+*  		can host a new game
+*  			-no moves for <game> may be in flight
+*
+* 	@param
+*	 - pool :: pool the game lives in
+*	 - game :: id returned by game_pool_new_game()
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: no such game
+*********************************************************************/
+short game_pool_reset_game(Game_Pool* pool, size_t game)
+{
+	if(!pool || game >= atomic_load_explicit(&pool->num_games, memory_order_acquire))
+		return FAILURE;
+
+	position_init(&pool->positions[game]);
+	pool->status[game] = GAME_ONGOING;
+	pool->plies[game] = 0;
+	return 0;
+}
+/*********************************************************************
+* size_t game_pool_submit(Game_Pool* pool, const Move_Request* requests,
+*		Move_Result* results, size_t count)
+*
+* 	PURPOSE ::
+*  		queue a batch of moves on the shards owning their games
+*  			-blocks while a shard queue is full
+*  			-<results> (may be NULL) is filled in as moves
+*  			finish, it is only safe to read after
+*  			game_pool_wait()
+*
+* 	@param
+*	 - pool     :: pool hosting the games
+*	 - requests :: <count> (game, move) pairs
+*	 - results  :: <count> slots for the verdicts, or NULL
+*	 - count    :: batch size
+*
+*	 @return
+*	 - size_t :: how many requests were queued, bad game ids
+*	 	     are answered MOVE_NO_GAME right away
+*********************************************************************/
+size_t game_pool_submit(Game_Pool* pool, const Move_Request* requests,
+		Move_Result* results, size_t count)
+{
+	if(!pool || !requests)
+	{
+		error_noexist("pool", "game_pool_submit");
+		return 0;
+	}
+
+	size_t queued = 0;
+	//pairs with the release in game_pool_new_game(), every id below
+	//this has its position set up
+	size_t num_games = atomic_load_explicit(&pool->num_games, memory_order_acquire);
+	for(size_t i = 0; i < count; ++i)
+	{
+		if(requests[i].game >= num_games)
+		{
+			if(results)
+			{
+				results[i].verdict = MOVE_NO_GAME;
+				results[i].status = GAME_ONGOING;
+			}
+			continue;
+		}
+
+		Pool_Job job = {
+			.request = requests[i],
+			.result = results ? &results[i] : NULL,
+			.submitted_ns = time_now_ns()
+		};
+		Pool_Shard* shard = &pool->shards[requests[i].game % pool->num_shards];
+
+		atomic_fetch_add_explicit(&pool->pending, 1, memory_order_relaxed);
+		while(ring_queue_push(&shard->queue, &job) != TRUE)
+			sched_yield();
+		queued++;
+	}
+	return queued;
+}
+/*********************************************************************
+* void game_pool_wait(Game_Pool* pool)
+*
+* 	PURPOSE ::
+*  		block until every submitted move has been answered
+*
+* 	@param
+*	 - pool :: pool to drain
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void game_pool_wait(Game_Pool* pool)
+{
+	while(atomic_load_explicit(&pool->pending, memory_order_acquire) != 0)
+		sched_yield();
+	return;
+}
+/*********************************************************************
+* void game_pool_stats(Game_Pool* pool, Pool_Stats* stats)
+*
+* 	PURPOSE ::
+*  		merge the per-shard counters into <stats>
+*  			-call after game_pool_wait(), the shards
+*  			write their counters without locking
+*
+* 	@param
+*	 - pool  :: pool to report on
+*	 - stats :: receives the totals
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void game_pool_stats(Game_Pool* pool, Pool_Stats* stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	Latency_Histogram* merged = (Latency_Histogram*)calloc(1, sizeof(Latency_Histogram));
+	if(!merged)
+		error_nomem();
+
+	unsigned long long last_done = pool->start_ns;
+	for(size_t i = 0; i < pool->num_shards; ++i)
+	{
+		Pool_Shard* shard = &pool->shards[i];
+		stats->applied  += shard->applied;
+		stats->rejected += shard->rejected;
+		latency_merge(merged, &shard->latency);
+		if(shard->last_done_ns > last_done)
+			last_done = shard->last_done_ns;
+	}
+
+	stats->moves = stats->applied + stats->rejected;
+	stats->seconds = (double)(last_done - pool->start_ns) / 1e9;
+	if(stats->seconds > 0.0)
+		stats->moves_per_second = (double)stats->moves / stats->seconds;
+	stats->p50_ns = latency_percentile(merged, 50.0);
+	stats->p99_ns = latency_percentile(merged, 99.0);
+	stats->max_ns = merged->max;
+
+	free(merged);
+	return;
+}
+/*********************************************************************
+* void game_pool_reset_stats(Game_Pool* pool)
+*
+* 	PURPOSE ::
+*  		zero the counters and restart the throughput clock
+*  			-only while nothing is in flight
+*
+* 	@param
+*	 - pool :: pool to reset
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void game_pool_reset_stats(Game_Pool* pool)
+{
+	for(size_t i = 0; i < pool->num_shards; ++i)
+	{
+		Pool_Shard* shard = &pool->shards[i];
+		shard->applied = 0;
+		shard->rejected = 0;
+		shard->last_done_ns = 0;
+		latency_reset(&shard->latency);
+	}
+	pool->start_ns = time_now_ns();
+	return;
+}
+/*********************************************************************
+* void game_pool_print_stats(Game_Pool* pool)
+*
+* 	PURPOSE ::
+*  		print throughput and latency of everything played
+*  		since the pool was made (or its stats were reset)
+*
+* 	@param
+*	 - pool :: pool to report on
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void game_pool_print_stats(Game_Pool* pool)
+{
+	Pool_Stats stats;
+	game_pool_stats(pool, &stats);
+
+	printf("games     : %zu on %zu shards\n", atomic_load(&pool->num_games), pool->num_shards);
+	printf("moves     : %llu (%llu applied, %llu rejected)\n",
+			stats.moves, stats.applied, stats.rejected);
+	printf("moves/sec : %.0f over %.3fs\n", stats.moves_per_second, stats.seconds);
+	printf("latency   : p50 %lluns  p99 %lluns  max %lluns\n",
+			stats.p50_ns, stats.p99_ns, stats.max_ns);
+	return;
+}
+#endif //GAME_POOL_IMPLEMENTATION_
+#endif //GAME_POOL_H_
@@ -0,0 +1,145 @@
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+///user defined
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+//log-linear buckets : 16 slots per power of two,
+//so any recorded value is off by at most ~6%
+#define LATENCY_SUB_BITS 4
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT)
+
+typedef struct Latency_Histogram
+{
+	unsigned long long counts[LATENCY_BUCKETS];
+	unsigned long long total;
+	unsigned long long max;
+} Latency_Histogram;
+
+void latency_reset(Latency_Histogram* hist);
+void latency_record(Latency_Histogram* hist, unsigned long long value);
+void latency_merge(Latency_Histogram* into, const Latency_Histogram* from);
+unsigned long long latency_percentile(const Latency_Histogram* hist, double percentile);
+
+#ifdef LATENCY_IMPLEMENTATION_
+
+/*********************************************************************
+* void latency_reset(Latency_Histogram* hist)
+*
+* 	PURPOSE ::
+*  		empty every bucket of <hist>
+*
+* 	@param
+*	 - hist :: histogram to clear
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void latency_reset(Latency_Histogram* hist)
+{
+	memset(hist, 0, sizeof(*hist));
+	return;
+}
+/*********************************************************************
+* void latency_record(Latency_Histogram* hist, unsigned long long value)
+*
+* 	PURPOSE ::
+*  		count one sample of <value> (usually nanoseconds)
+*  			-not thread safe, keep one histogram per thread
+*  			and merge them when reporting
+*
+* 	@param
+*	 - hist  :: histogram to update
+*	 - value :: the sample
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void latency_record(Latency_Histogram* hist, unsigned long long value)
+{
+	size_t bucket = 0;
+	if(value < LATENCY_SUB_COUNT)
+		bucket = (size_t)value;
+	else
+	{
+		//top set bit picks the power of two, the next bits pick the slot
+		size_t msb = 63 - (size_t)__builtin_clzll(value);
+		size_t sub = (size_t)(value >> (msb - LATENCY_SUB_BITS)) & (LATENCY_SUB_COUNT - 1);
+		bucket = (msb - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT + sub;
+	}
+
+	hist->counts[bucket]++;
+	hist->total++;
+	if(value > hist->max)
+		hist->max = value;
+	return;
+}
+/*********************************************************************
+* void latency_merge(Latency_Histogram* into, const Latency_Histogram* from)
+*
+* 	PURPOSE ::
+*  		add every sample of <from> to <into>
+*
+* 	@param
+*	 - into :: receives the samples
+*	 - from :: left untouched
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void latency_merge(Latency_Histogram* into, const Latency_Histogram* from)
+{
+	for(size_t i = 0; i < LATENCY_BUCKETS; ++i)
+		into->counts[i] += from->counts[i];
+	into->total += from->total;
+	if(from->max > into->max)
+		into->max = from->max;
+	return;
+}
+/*********************************************************************
+* unsigned long long latency_percentile(const Latency_Histogram* hist,
+*		double percentile)
+*
+* 	PURPOSE ::
+*  		find the value below which <percentile> percent of
+*  		the samples fall (50.0 -> median, 99.0 -> p99)
+*
+* 	@param
+*	 - hist       :: histogram to read
+*	 - percentile :: 0.0 .. 100.0
+*
+*	 @return
+*	 - unsigned long long :: lower edge of the matching bucket,
+*	 			 0 if nothing was recorded
+*********************************************************************/
+unsigned long long latency_percentile(const Latency_Histogram* hist, double percentile)
+{
+	if(hist->total == 0)
+		return 0;
+
+	unsigned long long rank = (unsigned long long)(percentile / 100.0 * (double)hist->total);
+	if(rank >= hist->total)
+		rank = hist->total - 1;
+
+	unsigned long long seen = 0;
+	for(size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket)
+	{
+		seen += hist->counts[bucket];
+		if(seen > rank)
+		{
+			if(bucket < LATENCY_SUB_COUNT)
+				return bucket;
+			size_t msb = bucket / LATENCY_SUB_COUNT + LATENCY_SUB_BITS - 1;
+			size_t sub = bucket % LATENCY_SUB_COUNT;
+			return (1ULL << msb) | ((unsigned long long)sub << (msb - LATENCY_SUB_BITS));
+		}
+	}
+	return hist->max;
+}
+#endif //LATENCY_IMPLEMENTATION_
+#endif //LATENCY_H_
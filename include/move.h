@@ -17,7 +17,7 @@ int is_path_clear(char** board,  const short origin[2], const short dest[2]);
 
 //validate piece-type moves (pawn, rook, etc)
 //   ~move to different file (validate.h/c)?
-short validate_pawn(char** board, const short row_diff, const short col_diff,
+int validate_pawn(char** board, const short row_diff, const short col_diff,
 		const short initial_row,  const short origin_row,
 	       	const char origin_piece, const char dest_piece);
 int validate_rook(char** board, const short row_diff, const short col_diff,
@@ -25,7 +25,7 @@ int validate_rook(char** board, const short row_diff, const short col_diff,
 int validate_knight(char** board, const short row_diff, const short col_diff,
 		const char origin_piece, const char dest_piece);
 int validate_bishop(char** board, const short row_diff, const short col_diff,
-		const char origin_piece, const char dest_piece);
+		const char origin_piece, const char dest_piece, Move move);
 int validate_king(char** board, const short row_diff, const short col_diff,
 		const char origin_piece, const char dest_piece);
 
@@ -110,12 +110,14 @@ int is_path_clear(char** board,  const short origin[2], const short dest[2])
 	short row_step = 0;
 	if(dest_row > origin_row)
 		row_step = 1;
-	else
-		 row_step = -1;
+	else if(dest_row < origin_row)
+		row_step = -1;
 
 	short col_step = 0;
 	if(dest_col > origin_col)
 		col_step = 1;
+	else if(dest_col < origin_col)
+		col_step = -1;
 
 	//calculate the next square to travel to, ensure it is empty
 	short next_square[2] = { (origin_row + row_step), (origin_col + col_step) };
@@ -296,11 +298,12 @@ int validate_knight(char** board, const short row_diff, const short col_diff,
 /*********************************************************************
 * short validate_bishop(char** board, const short row_diff, const short col_diff,
 *		const char origin_piece, const char dest_piece,
+*		 Move move)
 *
 *
 * 	PURPOSE ::
 *		confirm whether or not a potential attack or 
-*		movement of a rook piecetype is within
+*		movement of a bishop piecetype is within
 *		the confines of the chess rules
 *
 * 	@param 
@@ -309,6 +312,7 @@ int validate_knight(char** board, const short row_diff, const short col_diff,
 *	 - col_diff     :: the difference between the origin and destination columns (absolute value)
 *	 - origin_piece :: the single character that represents the piece type at origin tile
 *	 - dest_piece   :: the single character that represents the piece type at the requested tile
+*	 - move         :: the origin and destination tiles, used to walk the diagonal
 *
 *	 @return
 *	 - void :: short integer
@@ -316,7 +320,7 @@ int validate_knight(char** board, const short row_diff, const short col_diff,
 *	 	- zero (or poisitive)   :: something good happened
 *********************************************************************/
 int validate_bishop(char** board, const short row_diff, const short col_diff,
-		const char origin_piece, const char dest_piece)
+		const char origin_piece, const char dest_piece, Move move)
 {
 	if(!board)
 	{
@@ -328,7 +332,8 @@ int validate_bishop(char** board, const short row_diff, const short col_diff,
 	//so column and row should have the same difference
 	if (row_diff == col_diff)
 		if( is_available(board, origin_piece, dest_piece) == TRUE )
-			return TRUE;
+			if(is_path_clear(board, move.origin, move.dest) == TRUE)
+				return TRUE;
 	return FALSE;
 
 }
@@ -395,9 +400,9 @@ int is_move_legal(char** board,  Move move)
 	short dest_row    = move.dest[0];
 	short dest_col    = move.dest[1];
 
-	//if the origin and dest are the same square
+	//if the origin and dest are the same square, nothing moves
 	if ( (origin_row == dest_row) && (origin_col == dest_col) )
-		return TRUE;
+		return FALSE;
 	
 	//grab the row and col diff,
 	//dont want negative difference, use absolute value
@@ -425,6 +430,14 @@ int is_move_legal(char** board,  Move move)
 	{
 		case 'p':
 		{
+			//pawns never walk backwards, 
+			//uppercase (white) heads toward row 0
+			short forward = islower(origin_piece) ? 1 : -1;
+			if((dest_row - origin_row) * forward < 0)
+				return FALSE;
+			//the double step cannot hop over a piece
+			if(row_diff == 2 && is_path_clear(board, move.origin, move.dest) != TRUE)
+				return FALSE;
 			return validate_pawn(board, 
 			                     row_diff, col_diff, 
 				      	     initial_row, origin_row,
@@ -447,12 +460,13 @@ int is_move_legal(char** board,  Move move)
 		{
 			return validate_bishop(board,
 					       row_diff, col_diff,
-					       origin_piece, dest_piece);
+					       origin_piece, dest_piece,
+					       move);
 		}
 		case 'q':
 		{
 			if(validate_rook(board, row_diff, col_diff, origin_piece, dest_piece, move) == TRUE || 
-			   validate_bishop(board, row_diff, col_diff, origin_piece, dest_piece) == TRUE)
+			   validate_bishop(board, row_diff, col_diff, origin_piece, dest_piece, move) == TRUE)
 				return TRUE;
 			return FALSE;	
 		}
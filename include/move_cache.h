@@ -0,0 +1,390 @@
+#ifndef MOVE_CACHE_H_
+#define MOVE_CACHE_H_
+
+///user defined
+#include "position.h"
+#include "move_gen.h"
+#include "zobrist.h"
+#include "stats.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+//entries per set, the clock hand sweeps within a set
+#define CACHE_WAYS 8
+#define CACHE_DEFAULT_SHARDS 64
+
+typedef struct Cache_Entry
+{
+	unsigned long long key;
+	Packed_Moves moves;
+} Cache_Entry;
+
+typedef struct Cache_Set
+{
+	Cache_Entry ways[CACHE_WAYS];
+	unsigned char valid;		//bit per way
+	unsigned char referenced;	//bit per way, cleared as the hand passes
+	unsigned char hand;
+} Cache_Set;
+
+//one lock per shard, so threads only collide on the same shard
+typedef struct Cache_Shard
+{
+	pthread_mutex_t lock;
+	Cache_Set* sets;
+	size_t num_sets;
+
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned long long evictions;
+} Cache_Shard;
+
+typedef struct Move_Cache
+{
+	Cache_Shard* shards;
+	size_t num_shards;
+} Move_Cache;
+
+typedef struct Cache_Stats
+{
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned long long evictions;
+	size_t entries;
+	size_t capacity;
+	size_t memory_bytes;
+	double hit_rate;
+} Cache_Stats;
+
+Move_Cache* move_cache_create(size_t memory_bytes, size_t num_shards);
+void move_cache_destroy(Move_Cache* cache);
+int move_cache_probe(Move_Cache* cache, unsigned long long key, Packed_Moves* moves);
+void move_cache_store(Move_Cache* cache, unsigned long long key, const Packed_Moves* moves);
+void move_cache_generate(Move_Cache* cache, const Position* pos, Move_Set* set);
+int move_cache_is_legal(Move_Cache* cache, const Position* pos, Move move);
+void move_cache_stats(Move_Cache* cache, Cache_Stats* stats);
+void move_cache_print_stats(Move_Cache* cache);
+
+#ifdef MOVE_CACHE_IMPLEMENTATION_
+
+//low bits pick the shard, high bits the set, so the two stay independent
+#define CACHE_SHARD(cache, key) (&(cache)->shards[(key) & ((cache)->num_shards - 1)])
+#define CACHE_SET(shard, key) (&(shard)->sets[((key) >> 32) % (shard)->num_sets])
+
+/*********************************************************************
+* Move_Cache* move_cache_create(size_t memory_bytes, size_t num_shards)
+*
+* 	PURPOSE ::
+*  		allocate a cache holding as many positions as fit
+*  		in <memory_bytes>
+*
+* 	@param
+*	 - memory_bytes :: budget for the entries
+*	 - num_shards   :: lock count, rounded up to a power of two,
+*	 		   0 picks CACHE_DEFAULT_SHARDS
+*
+*	 @return
+*	 - NULL  :: on failure
+*	 - cache :: newly created cache on success
+*********************************************************************/
+Move_Cache* move_cache_create(size_t memory_bytes, size_t num_shards)
+{
+	if(num_shards == 0)
+		num_shards = CACHE_DEFAULT_SHARDS;
+	size_t shards = 1;
+	while(shards < num_shards)
+		shards <<= 1;
+
+	size_t sets_per_shard = memory_bytes / sizeof(Cache_Set) / shards;
+	if(sets_per_shard < 1)
+	{
+		fprintf(stderr, "Cache budget of %zu bytes is too small!\n", memory_bytes);
+		return NULL;
+	}
+
+	Move_Cache* cache = (Move_Cache*)malloc(sizeof(Move_Cache));
+	if(!cache)
+		return NULL;
+	cache->shards = (Cache_Shard*)calloc(shards, sizeof(Cache_Shard));
+	if(!cache->shards)
+	{
+		free(cache);
+		return NULL;
+	}
+	//counts shards as they come up, so a failure part way only
+	//tears down what exists
+	cache->num_shards = 0;
+
+	for(size_t i = 0; i < shards; ++i)
+	{
+		Cache_Shard* shard = &cache->shards[i];
+		if(pthread_mutex_init(&shard->lock, NULL) != 0)
+		{
+			move_cache_destroy(cache);
+			return NULL;
+		}
+		shard->num_sets = sets_per_shard;
+		shard->sets = (Cache_Set*)calloc(sets_per_shard, sizeof(Cache_Set));
+		if(!shard->sets)
+		{
+			pthread_mutex_destroy(&shard->lock);
+			move_cache_destroy(cache);
+			return NULL;
+		}
+		cache->num_shards++;
+	}
+	return cache;
+}
+/*********************************************************************
+* void move_cache_destroy(Move_Cache* cache)
+*
+* 	PURPOSE ::
+*  		free <cache> and every entry in it
+*
+* 	@param
+*	 - cache :: cache to tear down
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void move_cache_destroy(Move_Cache* cache)
+{
+	if(!cache)
+		return;
+	for(size_t i = 0; i < cache->num_shards; ++i)
+	{
+		pthread_mutex_destroy(&cache->shards[i].lock);
+		free(cache->shards[i].sets);
+	}
+	free(cache->shards);
+	free(cache);
+	return;
+}
+/*********************************************************************
+* int move_cache_probe(Move_Cache* cache, unsigned long long key,
+*		Packed_Moves* moves)
+*
+* 	PURPOSE ::
+*  		look <key> up, copying its moves out on a hit
+*
+* 	@param
+*	 - cache :: cache to search
+*	 - key   :: position_hash() of the position
+*	 - moves :: receives the moves on a hit
+*
+*	 @return
+*	 - TRUE  :: hit
+*	 - FALSE :: miss
+*********************************************************************/
+int move_cache_probe(Move_Cache* cache, unsigned long long key, Packed_Moves* moves)
+{
+	Cache_Shard* shard = CACHE_SHARD(cache, key);
+	int found = FALSE;
+
+	pthread_mutex_lock(&shard->lock);
+	Cache_Set* set = CACHE_SET(shard, key);
+	for(unsigned way = 0; way < CACHE_WAYS; ++way)
+	{
+		if( ((set->valid >> way) & 1) && set->ways[way].key == key )
+		{
+			*moves = set->ways[way].moves;
+			set->referenced |= (unsigned char)(1u << way);
+			found = TRUE;
+			break;
+		}
+	}
+	if(found)
+		shard->hits++;
+	else
+		shard->misses++;
+	pthread_mutex_unlock(&shard->lock);
+
+	STAT_INC(STAT_CACHE_PROBES);
+	if(found)
+		STAT_INC(STAT_CACHE_HITS);
+	return found;
+}
+/*********************************************************************
+* void move_cache_store(Move_Cache* cache, unsigned long long key,
+*		const Packed_Moves* moves)
+*
+* 	PURPOSE ::
+*  		insert (or refresh) <key>
+*  			-a full set evicts the first way the clock hand
+*  			finds without its referenced bit, clearing the
+*  			bits it passes over
+*
+* 	@param
+*	 - cache :: cache to fill
+*	 - key   :: position_hash() of the position
+*	 - moves :: the position's moves
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void move_cache_store(Move_Cache* cache, unsigned long long key, const Packed_Moves* moves)
+{
+	Cache_Shard* shard = CACHE_SHARD(cache, key);
+
+	pthread_mutex_lock(&shard->lock);
+	Cache_Set* set = CACHE_SET(shard, key);
+
+	unsigned victim = CACHE_WAYS;
+	for(unsigned way = 0; way < CACHE_WAYS; ++way)
+	{
+		if(!((set->valid >> way) & 1))
+		{
+			if(victim == CACHE_WAYS)
+				victim = way;
+		}
+		else if(set->ways[way].key == key)
+		{
+			victim = way;
+			break;
+		}
+	}
+
+	if(victim == CACHE_WAYS)
+	{
+		while((set->referenced >> set->hand) & 1)
+		{
+			set->referenced &= (unsigned char)~(1u << set->hand);
+			set->hand = (unsigned char)((set->hand + 1) % CACHE_WAYS);
+		}
+		victim = set->hand;
+		set->hand = (unsigned char)((set->hand + 1) % CACHE_WAYS);
+		shard->evictions++;
+	}
+
+	set->ways[victim].key = key;
+	set->ways[victim].moves = *moves;
+	set->valid |= (unsigned char)(1u << victim);
+	set->referenced &= (unsigned char)~(1u << victim);
+	pthread_mutex_unlock(&shard->lock);
+	return;
+}
+/*********************************************************************
+* void move_cache_generate(Move_Cache* cache, const Position* pos,
+*		Move_Set* set)
+*
+* 	PURPOSE ::
+*  		generate_moves() with the cache in front of it :
+*  		hot positions are answered without generating
+*
+* 	@param
+*	 - cache :: cache to consult and fill
+*	 - pos   :: the position to generate for
+*	 - set   :: overwritten with the moves
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void move_cache_generate(Move_Cache* cache, const Position* pos, Move_Set* set)
+{
+	unsigned long long key = position_hash(pos);
+	Packed_Moves packed;
+
+	if(move_cache_probe(cache, key, &packed) == TRUE)
+	{
+		move_set_unpack(&packed, set);
+		return;
+	}
+
+	generate_moves(pos, set);
+	if(move_set_pack(set, &packed) == 0)
+		move_cache_store(cache, key, &packed);
+	return;
+}
+/*********************************************************************
+* int move_cache_is_legal(Move_Cache* cache, const Position* pos, Move move)
+*
+* 	PURPOSE ::
+*  		answer "is <move> legal in <pos>" through the cache,
+*  		a hit never expands the packed moves
+*
+* 	@param
+*	 - cache :: cache to consult and fill
+*	 - pos   :: the position the move is played in
+*	 - move  :: origin / dest pair
+*
+*	 @return
+*	 - TRUE  :: the move may be played
+*	 - FALSE :: it may not
+*********************************************************************/
+int move_cache_is_legal(Move_Cache* cache, const Position* pos, Move move)
+{
+	unsigned long long key = position_hash(pos);
+	Packed_Moves packed;
+
+	if(move_cache_probe(cache, key, &packed) == TRUE)
+		return packed_moves_contains(&packed, move);
+
+	Move_Set set;
+	generate_moves(pos, &set);
+	if(move_set_pack(&set, &packed) == 0)
+		move_cache_store(cache, key, &packed);
+	return move_set_contains(&set, move);
+}
+/*********************************************************************
+* void move_cache_stats(Move_Cache* cache, Cache_Stats* stats)
+*
+* 	PURPOSE ::
+*  		sum the counters of every shard into <stats>
+*
+* 	@param
+*	 - cache :: cache to report on
+*	 - stats :: receives the totals
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void move_cache_stats(Move_Cache* cache, Cache_Stats* stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	for(size_t i = 0; i < cache->num_shards; ++i)
+	{
+		Cache_Shard* shard = &cache->shards[i];
+		pthread_mutex_lock(&shard->lock);
+		stats->hits      += shard->hits;
+		stats->misses    += shard->misses;
+		stats->evictions += shard->evictions;
+		stats->capacity  += shard->num_sets * CACHE_WAYS;
+		for(size_t s = 0; s < shard->num_sets; ++s)
+			stats->entries += (size_t)__builtin_popcount(shard->sets[s].valid);
+		pthread_mutex_unlock(&shard->lock);
+	}
+
+	stats->memory_bytes = stats->capacity / CACHE_WAYS * sizeof(Cache_Set);
+	if(stats->hits + stats->misses > 0)
+		stats->hit_rate = (double)stats->hits / (double)(stats->hits + stats->misses);
+	return;
+}
+/*********************************************************************
+* void move_cache_print_stats(Move_Cache* cache)
+*
+* 	PURPOSE ::
+*  		print the counters from move_cache_stats()
+*
+* 	@param
+*	 - cache :: cache to report on
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void move_cache_print_stats(Move_Cache* cache)
+{
+	Cache_Stats stats;
+	move_cache_stats(cache, &stats);
+
+	printf("entries   : %zu / %zu (%zu bytes)\n", stats.entries, stats.capacity, stats.memory_bytes);
+	printf("hits      : %llu (%.1f%%)\n", stats.hits, stats.hit_rate * 100.0);
+	printf("misses    : %llu\n", stats.misses);
+	printf("evictions : %llu\n", stats.evictions);
+	return;
+}
+#endif //MOVE_CACHE_IMPLEMENTATION_
+#endif //MOVE_CACHE_H_
@@ -0,0 +1,438 @@
+#ifndef MOVE_GEN_H_
+#define MOVE_GEN_H_
+
+///user defined
+#include "position.h"
+#include "stats.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+//squares are numbered row * NUM_COLS + col
+#define SQUARE(row, col) ((row) * NUM_COLS + (col))
+#define NUM_SQUARES (NUM_ROWS * NUM_COLS)
+//no position has more moves than this
+#define MAX_MOVES 256
+
+//every move the side to move has, one destination bitboard per origin square
+typedef struct Move_Set
+{
+	unsigned long long dests[NUM_SQUARES];
+} Move_Set;
+
+//the same moves without the empty origins : a side never has
+//more than 16 pieces, so 16 destination boards always suffice
+#define MAX_ORIGINS 16
+typedef struct Packed_Moves
+{
+	unsigned long long origins;
+	unsigned long long dests[MAX_ORIGINS];
+} Packed_Moves;
+
+void generate_moves(const Position* pos, Move_Set* set);
+int move_set_contains(const Move_Set* set, Move move);
+size_t move_set_count(const Move_Set* set);
+short move_set_pack(const Move_Set* set, Packed_Moves* packed);
+void move_set_unpack(const Packed_Moves* packed, Move_Set* set);
+int packed_moves_contains(const Packed_Moves* packed, Move move);
+size_t move_set_to_list(const Move_Set* set, Move* moves);
+unsigned short move_pack(Move move);
+Move move_unpack(unsigned short packed);
+int position_in_check(const Position* pos);
+
+#ifdef MOVE_GEN_IMPLEMENTATION_
+
+static const short KNIGHT_STEPS[8][2] = {
+	{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}
+};
+static const short KING_STEPS[8][2] = {
+	{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}
+};
+static const short ROOK_RAYS[4][2]   = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+static const short BISHOP_RAYS[4][2] = { {-1, -1}, {-1, 1}, {1, -1}, {1, 1} };
+
+/*********************************************************************
+* static int gen_on_board(short row, short col)
+*
+* 	PURPOSE ::
+*  		is <row>,<col> a square of the board
+*********************************************************************/
+static int gen_on_board(short row, short col)
+{
+	return row >= 0 && row < NUM_ROWS && col >= 0 && col < NUM_COLS;
+}
+/*********************************************************************
+* static int gen_is_enemy(char piece, short white)
+*
+* 	PURPOSE ::
+*  		is <piece> something the side (<white> or not) may capture
+*********************************************************************/
+static int gen_is_enemy(char piece, short white)
+{
+	if(piece == '.')
+		return FALSE;
+	return white ? (islower(piece) != 0) : (isupper(piece) != 0);
+}
+/*********************************************************************
+* static unsigned long long gen_steps(const Position* pos, short row,
+*		short col, const short steps[8][2], short white)
+*
+* 	PURPOSE ::
+*  		destinations of a knight or king on <row>,<col> :
+*  		every step landing on an empty or enemy square
+*********************************************************************/
+static unsigned long long gen_steps(const Position* pos, short row, short col,
+		const short steps[8][2], short white)
+{
+	unsigned long long dests = 0;
+	for(size_t i = 0; i < 8; ++i)
+	{
+		short r = row + steps[i][0];
+		short c = col + steps[i][1];
+		if(!gen_on_board(r, c))
+			continue;
+		char target = pos->squares[r][c];
+		if(target == '.' || gen_is_enemy(target, white))
+			dests |= 1ULL << SQUARE(r, c);
+	}
+	return dests;
+}
+/*********************************************************************
+* static unsigned long long gen_rays(const Position* pos, short row,
+*		short col, const short rays[4][2], short white)
+*
+* 	PURPOSE ::
+*  		destinations of a slider on <row>,<col> : walk each ray
+*  		until a piece, which is included if it is an enemy
+*********************************************************************/
+static unsigned long long gen_rays(const Position* pos, short row, short col,
+		const short rays[4][2], short white)
+{
+	unsigned long long dests = 0;
+	for(size_t i = 0; i < 4; ++i)
+	{
+		short r = row + rays[i][0];
+		short c = col + rays[i][1];
+		while(gen_on_board(r, c))
+		{
+			char target = pos->squares[r][c];
+			if(target != '.')
+			{
+				if(gen_is_enemy(target, white))
+					dests |= 1ULL << SQUARE(r, c);
+				break;
+			}
+			dests |= 1ULL << SQUARE(r, c);
+			r += rays[i][0];
+			c += rays[i][1];
+		}
+	}
+	return dests;
+}
+/*********************************************************************
+* static unsigned long long gen_pawn(const Position* pos, short row,
+*		short col, short white)
+*
+* 	PURPOSE ::
+*  		destinations of a pawn on <row>,<col> : one step onto an
+*  		empty square, two from the initial row over an empty
+*  		square, or one diagonal step onto an enemy
+*********************************************************************/
+static unsigned long long gen_pawn(const Position* pos, short row, short col, short white)
+{
+	unsigned long long dests = 0;
+	const short forward = white ? -1 : 1;
+	const short initial_row = white ? 6 : 1;
+	const short r = row + forward;
+
+	if(!gen_on_board(r, col))
+		return 0;
+
+	if(pos->squares[r][col] == '.')
+	{
+		dests |= 1ULL << SQUARE(r, col);
+		if(row == initial_row && pos->squares[r + forward][col] == '.')
+			dests |= 1ULL << SQUARE(r + forward, col);
+	}
+	if(col > 0 && gen_is_enemy(pos->squares[r][col - 1], white))
+		dests |= 1ULL << SQUARE(r, col - 1);
+	if(col < NUM_COLS - 1 && gen_is_enemy(pos->squares[r][col + 1], white))
+		dests |= 1ULL << SQUARE(r, col + 1);
+	return dests;
+}
+/*********************************************************************
+* void generate_moves(const Position* pos, Move_Set* set)
+*
+* 	PURPOSE ::
+*  		collect every move the side to move may play in <pos>
+*  			-accepts exactly what position_is_move_legal()
+*  			accepts, but for all moves at once
+*
+* 	@param
+*	 - pos :: the position to generate for
+*	 - set :: overwritten with the moves
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void generate_moves(const Position* pos, Move_Set* set)
+{
+	STAT_INC(STAT_MOVEGEN_CALLS);
+	STAT_TIMER(TIMER_MOVEGEN);
+	const short white = (pos->side == WHITE);
+
+	for(short row = 0; row < NUM_ROWS; ++row)
+		for(short col = 0; col < NUM_COLS; ++col)
+		{
+			const char piece = pos->squares[row][col];
+			unsigned long long dests = 0;
+
+			if(piece != '.' && (isupper(piece) != 0) == white)
+			{
+				switch(tolower(piece))
+				{
+					case 'p': dests = gen_pawn(pos, row, col, white);                 break;
+					case 'n': dests = gen_steps(pos, row, col, KNIGHT_STEPS, white);  break;
+					case 'b': dests = gen_rays(pos, row, col, BISHOP_RAYS, white);    break;
+					case 'r': dests = gen_rays(pos, row, col, ROOK_RAYS, white);      break;
+					case 'q': dests = gen_rays(pos, row, col, BISHOP_RAYS, white) |
+							  gen_rays(pos, row, col, ROOK_RAYS, white);      break;
+					case 'k': dests = gen_steps(pos, row, col, KING_STEPS, white);    break;
+					default: break;
+				}
+			}
+			set->dests[SQUARE(row, col)] = dests;
+		}
+	return;
+}
+/*********************************************************************
+* int position_in_check(const Position* pos)
+*
+* 	PURPOSE ::
+*  		could the other side take the king of the side to move
+*  		if it were its turn
+*  			-costs a full generate_moves(), meant for the
+*  			rare nodes where every move loses the king
+*
+* 	@param
+*	 - pos :: the position to test
+*
+*	 @return
+*	 - TRUE  :: the king is attacked
+*	 - FALSE :: it is not, or there is no king
+*********************************************************************/
+int position_in_check(const Position* pos)
+{
+	const char king = (pos->side == WHITE) ? 'K' : 'k';
+	int king_square = -1;
+	for(short row = 0; row < NUM_ROWS && king_square < 0; ++row)
+		for(short col = 0; col < NUM_COLS; ++col)
+			if(pos->squares[row][col] == king)
+			{
+				king_square = SQUARE(row, col);
+				break;
+			}
+	if(king_square < 0)
+		return FALSE;
+
+	Position other = *pos;
+	other.side = (pos->side == WHITE) ? BLACK : WHITE;
+	Move_Set set;
+	generate_moves(&other, &set);
+	unsigned long long attacked = 0;
+	for(size_t square = 0; square < NUM_SQUARES; ++square)
+		attacked |= set.dests[square];
+	return (attacked >> king_square) & 1ULL;
+}
+/*********************************************************************
+* int move_set_contains(const Move_Set* set, Move move)
+*
+* 	PURPOSE ::
+*  		answer "is <move> legal" from a generated set
+*
+* 	@param
+*	 - set  :: filled in by generate_moves()
+*	 - move :: origin / dest pair, may be off the board
+*
+*	 @return
+*	 - TRUE  :: <move> is in the set
+*	 - FALSE :: it is not
+*********************************************************************/
+int move_set_contains(const Move_Set* set, Move move)
+{
+	if(position_in_bounds(move) != TRUE)
+		return FALSE;
+	return (set->dests[SQUARE(move.origin[0], move.origin[1])] >>
+			SQUARE(move.dest[0], move.dest[1])) & 1ULL;
+}
+/*********************************************************************
+* size_t move_set_count(const Move_Set* set)
+*
+* 	PURPOSE ::
+*  		how many moves are in <set>
+*
+* 	@param
+*	 - set :: filled in by generate_moves()
+*
+*	 @return
+*	 - size_t :: number of moves, 0 means the side is stuck
+*********************************************************************/
+size_t move_set_count(const Move_Set* set)
+{
+	size_t count = 0;
+	for(size_t sq = 0; sq < NUM_SQUARES; ++sq)
+		count += (size_t)__builtin_popcountll(set->dests[sq]);
+	return count;
+}
+/*********************************************************************
+* short move_set_pack(const Move_Set* set, Packed_Moves* packed)
+*
+* 	PURPOSE ::
+*  		squeeze <set> down to the origins that have moves
+*
+* 	@param
+*	 - set    :: filled in by generate_moves()
+*	 - packed :: overwritten with the same moves
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: more than MAX_ORIGINS pieces can move,
+*	 	      only possible in a hand-made position
+*********************************************************************/
+short move_set_pack(const Move_Set* set, Packed_Moves* packed)
+{
+	size_t used = 0;
+	memset(packed, 0, sizeof(*packed));
+	for(size_t sq = 0; sq < NUM_SQUARES; ++sq)
+	{
+		if(!set->dests[sq])
+			continue;
+		if(used == MAX_ORIGINS)
+			return FAILURE;
+		packed->origins |= 1ULL << sq;
+		packed->dests[used++] = set->dests[sq];
+	}
+	return 0;
+}
+/*********************************************************************
+* void move_set_unpack(const Packed_Moves* packed, Move_Set* set)
+*
+* 	PURPOSE ::
+*  		expand <packed> back to one board per origin square
+*
+* 	@param
+*	 - packed :: filled in by move_set_pack()
+*	 - set    :: overwritten with the same moves
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void move_set_unpack(const Packed_Moves* packed, Move_Set* set)
+{
+	size_t used = 0;
+	for(size_t sq = 0; sq < NUM_SQUARES; ++sq)
+		set->dests[sq] = ((packed->origins >> sq) & 1ULL) ? packed->dests[used++] : 0;
+	return;
+}
+/*********************************************************************
+* int packed_moves_contains(const Packed_Moves* packed, Move move)
+*
+* 	PURPOSE ::
+*  		move_set_contains() for the packed form
+*  			-the slot of an origin is the number of
+*  			origins below it
+*
+* 	@param
+*	 - packed :: filled in by move_set_pack()
+*	 - move   :: origin / dest pair, may be off the board
+*
+*	 @return
+*	 - TRUE  :: <move> is in the set
+*	 - FALSE :: it is not
+*********************************************************************/
+int packed_moves_contains(const Packed_Moves* packed, Move move)
+{
+	if(position_in_bounds(move) != TRUE)
+		return FALSE;
+
+	const unsigned long long origin = 1ULL << SQUARE(move.origin[0], move.origin[1]);
+	if(!(packed->origins & origin))
+		return FALSE;
+
+	size_t slot = (size_t)__builtin_popcountll(packed->origins & (origin - 1));
+	return (packed->dests[slot] >> SQUARE(move.dest[0], move.dest[1])) & 1ULL;
+}
+/*********************************************************************
+* size_t move_set_to_list(const Move_Set* set, Move* moves)
+*
+* 	PURPOSE ::
+*  		spell <set> out as an array of moves, in square order
+*
+* 	@param
+*	 - set   :: filled in by generate_moves()
+*	 - moves :: room for move_set_count() moves
+*	 	    (MAX_MOVES always suffices)
+*
+*	 @return
+*	 - size_t :: number of moves written
+*********************************************************************/
+size_t move_set_to_list(const Move_Set* set, Move* moves)
+{
+	size_t count = 0;
+	for(size_t sq = 0; sq < NUM_SQUARES; ++sq)
+		for(unsigned long long dests = set->dests[sq]; dests; dests &= dests - 1)
+		{
+			size_t dest = (size_t)__builtin_ctzll(dests);
+			moves[count].origin[0] = (short)(sq / NUM_COLS);
+			moves[count].origin[1] = (short)(sq % NUM_COLS);
+			moves[count].dest[0]   = (short)(dest / NUM_COLS);
+			moves[count].dest[1]   = (short)(dest % NUM_COLS);
+			count++;
+		}
+	return count;
+}
+/*********************************************************************
+* unsigned short move_pack(Move move)
+*
+* 	PURPOSE ::
+*  		squeeze <move> into 12 bits
+*  			-a null move packs to 0, no real move does
+*
+* 	@param
+*	 - move :: an on-board move
+*
+*	 @return
+*	 - unsigned short :: origin square << 6 | dest square
+*********************************************************************/
+unsigned short move_pack(Move move)
+{
+	unsigned origin = (unsigned)SQUARE(move.origin[0], move.origin[1]);
+	unsigned dest   = (unsigned)SQUARE(move.dest[0], move.dest[1]);
+	return (unsigned short)((origin << 6) | dest);
+}
+/*********************************************************************
+* Move move_unpack(unsigned short packed)
+*
+* 	PURPOSE ::
+*  		undo move_pack()
+*
+* 	@param
+*	 - packed :: value from move_pack()
+*
+*	 @return
+*	 - Move :: the move
+*********************************************************************/
+Move move_unpack(unsigned short packed)
+{
+	Move move;
+	move.origin[0] = (short)((packed >> 6) / NUM_COLS);
+	move.origin[1] = (short)((packed >> 6) % NUM_COLS);
+	move.dest[0]   = (short)((packed & 63) / NUM_COLS);
+	move.dest[1]   = (short)((packed & 63) % NUM_COLS);
+	return move;
+}
+#endif //MOVE_GEN_IMPLEMENTATION_
+#endif //MOVE_GEN_H_
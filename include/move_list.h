@@ -2,14 +2,18 @@
 #define MOVE_LIST_H
 
 #include "util.h"
+#include "arena.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <assert.h>
 
 typedef struct Move_List
 {
 	Move* moves;
 	size_t size;
 	size_t capacity;
+	Arena* arena;	//NULL when the moves live on the heap
 
 } Move_List;
 
@@ -17,14 +21,15 @@ typedef struct Move_List
 void free_move(Move* move);
 void free_list(Move_List *list);
 Move_List init_list(size_t capacity);
+Move_List init_list_arena(Arena* arena, size_t capacity);
 
 //add / remove
 short add_move(Move_List *list, Move move);
-short compare_move(Move m1, Move m2);
+short compare_move(const Move *m1, const Move *m2);
 short remove_move(Move_List *list, Move move);
 
 
-#define MOVE_LIST_IMPLEMENTATION_
+#ifdef MOVE_LIST_IMPLEMENTATION_
 
 /*******************************************************
  * void free_move(Move* move);
@@ -51,13 +56,14 @@ void free_move(Move* move)
  *   
  *   PURPOSE ::
  *   	free an entire list, pointed to by
- *   	parameter <list>. Calls free_move()
- *   	iteratively to free each move, decrements
- *   	size per iteration
+ *   	parameter <list>. The moves are stored
+ *   	by value in one block, so that block is
+ *   	all there is to free. An arena list
+ *   	leaves its block to the arena
  *
  *   	@param 
- *  	   - move :: a Move structure that contains a
- *  	   	     short origin[2], dest[2] pair
+ *  	   - list :: the list to empty, left with
+ *  	   	     size and capacity 0
  *  	@return
  *  	   - void :: nothing
  *
@@ -65,15 +71,18 @@ void free_move(Move* move)
  *******************************************************/
 void free_list(Move_List *list)
 {
-	for(size_t i = 0; i < list->size; ++i)
-	{
-		free_move(list->moves[i]);
-		list->size--;	
-	}
+	if(!list)
+		return;
+
+	if(!list->arena)
+		free(list->moves);
+	list->moves = NULL;
+	list->size = 0;
+	list->capacity = 0;
 	return;
 }
 /*******************************************************
- * void init_list(size_t *capacity);
+ * Move_List init_list(size_t capacity);
  *   
  *   PURPOSE ::
  *	Initialize a new list of moves,
@@ -82,47 +91,100 @@ void free_list(Move_List *list)
  *
  *
  *   	@param 
- *  	   - move :: a Move structure that contains a
- *  	   	     short origin[2], dest[2] pair
+ *  	   - capacity :: moves to make room for,
+ *  	   		 the list grows past it as needed
  *
  *  	@return
- *  	   - NULL :: on failure
- *  	   - list :: newly created list on success
+ *  	   - list :: newly created list, with
+ *  	   	     capacity 0 on failure
  *
  *
  *******************************************************/
 Move_List init_list(size_t capacity)
 {
+	Move_List list = {
+		.moves = NULL,
+		.size = 0,
+		.capacity = 0,
+		.arena = NULL
+	};
+
 	if(capacity < 1)
 	{
 		fprintf(stderr, "Capacity must be non-zero!\n");
-		return;
+		return list;
 	}
 
-	Move_List list;
-	list = {
+	list.moves = (Move*)malloc(capacity * sizeof(Move));
+	if(!list.moves)
+	{
+		error_nomem();
+		return list;
+	}
+	list.capacity = capacity;
+	return list;
+}
+/*******************************************************
+ * Move_List init_list_arena(Arena* arena, size_t capacity);
+ *   
+ *   PURPOSE ::
+ *	init_list(), with the moves carved from
+ *	<arena> so neither this call nor add_move()
+ *	touches the heap once the arena is warm
+ *
+ *
+ *   	@param 
+ *  	   - arena    :: arena to carve from,
+ *  	   		 it owns the moves
+ *  	   - capacity :: moves to make room for,
+ *  	   		 the list grows past it as needed
+ *
+ *  	@return
+ *  	   - list :: newly created list, with
+ *  	   	     capacity 0 on failure
+ *
+ *
+ *******************************************************/
+Move_List init_list_arena(Arena* arena, size_t capacity)
+{
+	Move_List list = {
 		.moves = NULL,
 		.size = 0,
-		.capacity = capacity
+		.capacity = 0,
+		.arena = arena
 	};
-	return NULL;
+
+	if(capacity < 1)
+	{
+		fprintf(stderr, "Capacity must be non-zero!\n");
+		return list;
+	}
+
+	list.moves = (Move*)arena_alloc(arena, capacity * sizeof(Move));
+	if(!list.moves)
+	{
+		error_nomem();
+		return list;
+	}
+	list.capacity = capacity;
+	return list;
 }
 /*******************************************************
  * short add_move(Move_List *list, Move move)
  *   
  *   PURPOSE ::
- *	Initialize a new list of moves,
- *	where each element contains a 
- *	short origin[2], dest[2] pair
+ *	Append <move> to the end of <list>,
+ *	doubling the capacity when it is full
  *
  *
  *   	@param 
+ *  	   - list :: the list to grow
  *  	   - move :: a Move structure that contains a
  *  	   	     short origin[2], dest[2] pair
  *
  *  	@return
- *  	   - NULL :: on failure
- *  	   - list :: newly created list on success
+ *  	   - FAILURE :: on failure
+ *  	   - 0       :: on success
  *
  *
  *******************************************************/
@@ -130,33 +192,34 @@ short add_move(Move_List *list, Move move)
 {
 	if(!list)
 	{
-		error_noexist(#list, #add_move);
+		error_noexist("list", "add_move");
 		return FAILURE;
 	}
 	
-	list->moves[size - 1] = move;
-	list->size++;
-
-	if(list->size >= list->capacity / 2)
+	if(list->size == list->capacity)
 	{	
-		list->capacity = list->capacity * 2;
-		list->moves = (Move*)realloc(list->moves, list->capacity * sizeof(Move));
-		if(!list->moves)
+		size_t capacity = list->capacity ? list->capacity * 2 : 8;
+		Move* moves = list->arena
+			? (Move*)arena_grow(list->arena, list->moves,
+					list->capacity * sizeof(Move), capacity * sizeof(Move))
+			: (Move*)realloc(list->moves, capacity * sizeof(Move));
+		if(!moves)
 		{
 			error_nomem();
 			return FAILURE;
 		}
+		list->moves = moves;
+		list->capacity = capacity;
 	}
-	
+
+	list->moves[list->size++] = move;
 	return 0;
 }
 /*******************************************************
- * short compare_move(Move *m1, Move *m2)
+ * short compare_move(const Move *m1, const Move *m2)
  *   
  *   PURPOSE ::
- *	Initialize a new list of moves,
- *	where each element contains a 
- *	short origin[2], dest[2] pair
+ *	Compare two moves square by square
  *
  *
  *   	@param 
@@ -166,11 +229,11 @@ short add_move(Move_List *list, Move move)
  *  	   	     short origin[2], dest[2] pair
  
  *  	@return
- *  	   - FALSE :: false
- *  	   - TRUE  :: true...?
+ *  	   - FALSE :: the moves differ
+ *  	   - TRUE  :: same origin and dest
  *
  *******************************************************/
-short compare_move(Move *m1, Move *m2)
+short compare_move(const Move *m1, const Move *m2)
 {
 	assert(m1);
 	assert(m2);
@@ -179,7 +242,7 @@ short compare_move(Move *m1, Move *m2)
 	if(m1->dest[0] != m2->dest[0])		return FALSE;
 
 	if(m1->origin[1] != m2->origin[1]) 	return FALSE;
-	if(m1->dest[1] != m2->origin[1])	return FALSE;
+	if(m1->dest[1] != m2->dest[1])		return FALSE;
 
 	return TRUE;
 }
@@ -187,34 +250,39 @@ short compare_move(Move *m1, Move *m2)
  * short remove_move(Move_List *list, Move move)
  *   
  *   PURPOSE ::
- *	Initialize a new list of moves,
- *	where each element contains a 
- *	short origin[2], dest[2] pair
+ *	Remove the first copy of <move> from
+ *	<list>, the moves after it shift down
+ *	so the order is kept
  *
  *
  *   	@param 
+ *  	   - list :: the list to search
  *  	   - move :: a Move structure that contains a
  *  	   	     short origin[2], dest[2] pair
  *
  *  	@return
- *  	   - NULL :: on failure
- *  	   - list :: newly created list on success
+ *  	   - FAILURE :: <move> is not in the list
+ *  	   - 0       :: removed
  *
  *
  *******************************************************/
 short remove_move(Move_List *list, Move move)
 {
-	Move *curr_move = list->move[0];
-	
+	if(!list)
+	{
+		error_noexist("list", "remove_move");
+		return FAILURE;
+	}
+
 	for(size_t i = 0; i < list->size; ++i)
 	{
-		if(compare_move(curr_move, move)
+		if(compare_move(&list->moves[i], &move))
 		{
-			free_move(curr_move);
+			memmove(&list->moves[i], &list->moves[i + 1],
+					(list->size - i - 1) * sizeof(Move));
 			list->size--;
 			return 0;
 		}
-		curr_move = list->move[i+1]
 	}
 	return FAILURE;
 }
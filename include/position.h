@@ -0,0 +1,304 @@
+#ifndef POSITION_H_
+#define POSITION_H_
+
+///user defined
+#include "board.h"
+#include "move.h"
+#include "stats.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+//who is to move, uppercase pieces are white
+#define WHITE 'w'
+#define BLACK 'b'
+
+//fifty full moves without a capture or pawn move
+#define FIFTY_MOVE_PLIES 100
+
+typedef enum Game_Status
+{
+	GAME_ONGOING = 0,
+	GAME_WHITE_WINS,
+	GAME_BLACK_WINS,
+	GAME_DRAW
+} Game_Status;
+
+//a whole game state in one flat block,
+//so many of them can sit next to each other in memory
+typedef struct Position
+{
+	char squares[NUM_ROWS][NUM_COLS];
+	char side;
+	unsigned short halfmove;
+	unsigned short fullmove;
+} Position;
+
+//enough to take a move back
+typedef struct Undo
+{
+	Move move;
+	char moved;
+	char captured;
+	unsigned short halfmove;
+	unsigned short fullmove;
+} Undo;
+
+void position_init(Position* pos);
+void position_rows(Position* pos, char* rows[NUM_ROWS]);
+int position_in_bounds(Move move);
+int position_is_move_legal(Position* pos, Move move);
+char position_make_move(Position* pos, Move move);
+char position_make_move_undo(Position* pos, Move move, Undo* undo);
+void position_unmake_move(Position* pos, const Undo* undo);
+Game_Status position_status(const Position* pos);
+
+#ifdef POSITION_IMPLEMENTATION_
+
+/*********************************************************************
+* void position_init(Position* pos)
+*
+* 	PURPOSE ::
+*  		set <pos> up as the starting position,
+*  		same layout init_board() hands out
+*
+* 	@param
+*	 - pos :: position to overwrite
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void position_init(Position* pos)
+{
+	if(!pos)
+	{
+		error_noexist("pos", "position_init");
+		return;
+	}
+
+	static const char start[NUM_ROWS][NUM_COLS] = {
+		{'r', 'n', 'b', 'q', 'k', 'b', 'n', 'r' },
+		{'p', 'p', 'p', 'p', 'p', 'p', 'p', 'p' },
+		{'.', '.', '.', '.', '.', '.', '.', '.' },
+		{'.', '.', '.', '.', '.', '.', '.', '.' },
+		{'.', '.', '.', '.', '.', '.', '.', '.' },
+		{'.', '.', '.', '.', '.', '.', '.', '.' },
+		{'P', 'P', 'P', 'P', 'P', 'P', 'P', 'P' },
+		{'R', 'N', 'B', 'Q', 'K', 'B', 'N', 'R' }
+	};
+
+	memcpy(pos->squares, start, sizeof(start));
+	pos->side = WHITE;
+	pos->halfmove = 0;
+	pos->fullmove = 1;
+	return;
+}
+/*********************************************************************
+* void position_rows(Position* pos, char* rows[NUM_ROWS])
+*
+* 	PURPOSE ::
+*  		point <rows> at the rows of <pos>, so the flat
+*  		position can be handed to anything expecting
+*  		the char** board (is_move_legal, draw_board, ...)
+*  			-no copy is made, writes go through to <pos>
+*
+* 	@param
+*	 - pos  :: the position to view
+*	 - rows :: caller-owned array of NUM_ROWS row pointers
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void position_rows(Position* pos, char* rows[NUM_ROWS])
+{
+	for(size_t row = 0; row < NUM_ROWS; ++row)
+		rows[row] = pos->squares[row];
+	return;
+}
+/*********************************************************************
+* int position_in_bounds(Move move)
+*
+* 	PURPOSE ::
+*  		make sure both ends of <move> are on the board,
+*  		the char** validators trust their input
+*
+* 	@param
+*	 - move :: origin / dest pair to check
+*
+*	 @return
+*	 - TRUE  :: every coordinate is within 0..7
+*	 - FALSE :: otherwise
+*********************************************************************/
+int position_in_bounds(Move move)
+{
+	if(move.origin[0] < 0 || move.origin[0] >= NUM_ROWS) return FALSE;
+	if(move.origin[1] < 0 || move.origin[1] >= NUM_COLS) return FALSE;
+	if(move.dest[0] < 0   || move.dest[0] >= NUM_ROWS)   return FALSE;
+	if(move.dest[1] < 0   || move.dest[1] >= NUM_COLS)   return FALSE;
+	return TRUE;
+}
+/*********************************************************************
+* int position_is_move_legal(Position* pos, Move move)
+*
+* 	PURPOSE ::
+*  		is_move_legal() plus the checks that need the
+*  		game state : bounds, and that the side to move
+*  		owns the piece being moved
+*
+* 	@param
+*	 - pos  :: the position the move is played in
+*	 - move :: origin / dest pair
+*
+*	 @return
+*	 - TRUE  :: the move may be played
+*	 - FALSE :: it may not
+*	 - -1    :: <pos> does not exist
+*********************************************************************/
+int position_is_move_legal(Position* pos, Move move)
+{
+	if(!pos)
+	{
+		error_noexist("pos", "position_is_move_legal");
+		return -1;
+	}
+	if(position_in_bounds(move) != TRUE)
+		return FALSE;
+
+	const char origin_piece = pos->squares[move.origin[0]][move.origin[1]];
+	if(origin_piece == '.')
+		return FALSE;
+	if( (pos->side == WHITE) != (isupper(origin_piece) != 0) )
+		return FALSE;
+
+	char* rows[NUM_ROWS];
+	position_rows(pos, rows);
+	return is_move_legal(rows, move);
+}
+/*********************************************************************
+* char position_make_move(Position* pos, Move move)
+*
+* 	PURPOSE ::
+*  		play <move> on <pos> and advance the game state
+*  			-movement validation should occur before function
+*  			is called
+*  			-pawns reaching the far row become queens
+*
+* 	@param
+*	 - pos  :: the position to update
+*	 - move :: origin / dest pair
+*
+*	 @return
+*	 - char :: whatever stood on the destination ('.' if empty)
+*********************************************************************/
+char position_make_move(Position* pos, Move move)
+{
+	char piece    = pos->squares[move.origin[0]][move.origin[1]];
+	char captured = pos->squares[move.dest[0]][move.dest[1]];
+
+	if(tolower(piece) == 'p' || captured != '.')
+		pos->halfmove = 0;
+	else
+		pos->halfmove++;
+
+	if(piece == 'P' && move.dest[0] == 0)
+		piece = 'Q';
+	else if(piece == 'p' && move.dest[0] == NUM_ROWS - 1)
+		piece = 'q';
+
+	pos->squares[move.dest[0]][move.dest[1]] = piece;
+	pos->squares[move.origin[0]][move.origin[1]] = '.';
+
+	if(pos->side == BLACK)
+		pos->fullmove++;
+	pos->side = (pos->side == WHITE) ? BLACK : WHITE;
+	return captured;
+}
+/*********************************************************************
+* char position_make_move_undo(Position* pos, Move move, Undo* undo)
+*
+* 	PURPOSE ::
+*  		position_make_move(), remembering in <undo> what it
+*  		takes to put <pos> back
+*
+* 	@param
+*	 - pos  :: the position to update
+*	 - move :: origin / dest pair
+*	 - undo :: filled in for position_unmake_move()
+*
+*	 @return
+*	 - char :: whatever stood on the destination ('.' if empty)
+*********************************************************************/
+char position_make_move_undo(Position* pos, Move move, Undo* undo)
+{
+	STAT_TIMER(TIMER_MAKE_UNMAKE);
+	undo->move = move;
+	undo->moved = pos->squares[move.origin[0]][move.origin[1]];
+	undo->halfmove = pos->halfmove;
+	undo->fullmove = pos->fullmove;
+	undo->captured = position_make_move(pos, move);
+	return undo->captured;
+}
+/*********************************************************************
+* void position_unmake_move(Position* pos, const Undo* undo)
+*
+* 	PURPOSE ::
+*  		take back the move recorded in <undo>
+*  			-moves must be taken back in reverse order
+*
+* 	@param
+*	 - pos  :: the position to restore
+*	 - undo :: filled in by position_make_move_undo()
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void position_unmake_move(Position* pos, const Undo* undo)
+{
+	STAT_TIMER(TIMER_MAKE_UNMAKE);
+	pos->squares[undo->move.origin[0]][undo->move.origin[1]] = undo->moved;
+	pos->squares[undo->move.dest[0]][undo->move.dest[1]] = undo->captured;
+	pos->halfmove = undo->halfmove;
+	pos->fullmove = undo->fullmove;
+	pos->side = (pos->side == WHITE) ? BLACK : WHITE;
+	return;
+}
+/*********************************************************************
+* Game_Status position_status(const Position* pos)
+*
+* 	PURPOSE ::
+*  		decide whether the game in <pos> is over
+*  			-there is no check rule yet, so a game ends
+*  			when a king is taken
+*  			-fifty moves without progress is a draw
+*
+* 	@param
+*	 - pos :: the position to inspect
+*
+*	 @return
+*	 - Game_Status :: GAME_ONGOING, or who won / GAME_DRAW
+*********************************************************************/
+Game_Status position_status(const Position* pos)
+{
+	short white_king = FALSE;
+	short black_king = FALSE;
+
+	for(size_t row = 0; row < NUM_ROWS; ++row)
+		for(size_t col = 0; col < NUM_COLS; ++col)
+		{
+			if(pos->squares[row][col] == 'K') white_king = TRUE;
+			if(pos->squares[row][col] == 'k') black_king = TRUE;
+		}
+
+	if(!white_king)
+		return GAME_BLACK_WINS;
+	if(!black_king)
+		return GAME_WHITE_WINS;
+	if(pos->halfmove >= FIFTY_MOVE_PLIES)
+		return GAME_DRAW;
+	return GAME_ONGOING;
+}
+#endif //POSITION_IMPLEMENTATION_
+#endif //POSITION_H_
@@ -0,0 +1,1224 @@
+#ifndef POSITION_DB_H_
+#define POSITION_DB_H_
+
+///user defined
+#include "position.h"
+#include "move_gen.h"
+#include "zobrist.h"
+#include "fen.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DB_MAGIC "CHESSDB1"
+#define DB_VERSION 1
+//the table is kept at most half full so probes stay short
+#define DB_LOAD_FACTOR 2
+//log suffix, appended entries wait here for the next merge
+#define DB_LOG_SUFFIX ".log"
+#define DB_TMP_SUFFIX ".tmp"
+//undo file of an in-place merge, there only while one runs
+#define DB_UNDO_SUFFIX ".undo"
+//a log at most 1/8 of the table goes in place, anything bigger
+//rebuilds the table
+#define DB_IN_PLACE_RATIO 8
+#define DB_PATH_MAX 4096
+//Db_Entry.flags : score / best move / depth are filled in
+#define DB_FLAG_ANALYSIS 1
+
+//one analyzed position, key 0 marks an empty slot
+typedef struct Db_Entry
+{
+	unsigned long long key;
+	//the analysis is also one word, so merges can swap it whole
+	union
+	{
+		struct
+		{
+			short score;			//centipawns, side to move
+			unsigned short best_move;	//move_pack(), 0 for none
+			unsigned short depth;
+			unsigned short flags;
+		};
+		unsigned long long analysis;
+	};
+	unsigned int games;
+	unsigned int white_wins;
+	unsigned int black_wins;
+	unsigned int draws;
+} Db_Entry;
+
+typedef struct Db_Header
+{
+	char magic[8];
+	unsigned int version;
+	unsigned int entry_size;
+	unsigned long long capacity;	//power of two
+	unsigned long long count;
+	unsigned long long log_generation;	//last log merged in, 0 for none
+	unsigned char padding[24];
+} Db_Header;
+
+//an opened database : the table stays on disk, only the pages
+//lookups touch are ever read in
+typedef struct Position_DB
+{
+	int fd;
+	void* map;
+	size_t map_size;
+	const Db_Header* header;
+	const Db_Entry* entries;
+	unsigned long long mask;
+
+	//log entries not yet merged, sorted by key, and the generation
+	//the table takes once they are
+	Db_Entry* overlay;
+	size_t overlay_count;
+	unsigned long long overlay_generation;
+} Position_DB;
+
+typedef struct Db_Merger
+{
+	pthread_t thread;
+	char path[DB_PATH_MAX];
+	unsigned long long interval_ms;
+	size_t min_log_entries;
+	volatile int running;
+} Db_Merger;
+
+unsigned long long db_key(const Position* pos);
+
+Position_DB* position_db_open(const char* path);
+void position_db_close(Position_DB* db);
+int position_db_lookup(const Position_DB* db, unsigned long long key, Db_Entry* entry);
+
+short position_db_build(const char* path, const Db_Entry* entries, size_t count,
+		size_t num_threads);
+short position_db_build_epd(const char* path, const char* epd_path, size_t num_threads);
+short position_db_append(const char* path, const Db_Entry* entries, size_t count);
+short position_db_merge_log(const char* path);
+Db_Merger* position_db_start_merger(const char* path, unsigned long long interval_ms,
+		size_t min_log_entries);
+void position_db_stop_merger(Db_Merger* merger);
+
+#ifdef POSITION_DB_IMPLEMENTATION_
+
+_Static_assert(sizeof(Db_Entry) == 32, "Db_Entry must stay 32 bytes");
+_Static_assert(sizeof(Db_Header) == 64, "Db_Header must stay 64 bytes");
+_Static_assert(offsetof(Db_Entry, analysis) == 8 && offsetof(Db_Entry, flags) == 14,
+		"the analysis word must cover score, best_move, depth and flags");
+
+//first record of every log. Key 0 never names a position, so it
+//cannot be taken for one. A merge stamps the table with the log's
+//generation before emptying the log, a log whose generation the
+//table already carries was merged by a merge that died before
+//emptying it
+typedef struct Db_Log_Marker
+{
+	unsigned long long zero;
+	unsigned long long generation;
+	unsigned char padding[16];
+} Db_Log_Marker;
+
+_Static_assert(sizeof(Db_Log_Marker) == sizeof(Db_Entry), "a log marker must be one entry long");
+
+//one slot an in-place merge is about to overwrite, as it was. The
+//undo file is the table's header as it was, then these
+typedef struct Db_Undo_Record
+{
+	unsigned long long slot;
+	Db_Entry entry;
+} Db_Undo_Record;
+
+/*********************************************************************
+* unsigned long long db_key(const Position* pos)
+*
+* 	PURPOSE ::
+*  		the key <pos> is stored under : its zobrist hash,
+*  		with 0 moved to 1 since 0 marks an empty slot
+*
+* 	@param
+*	 - pos :: the position
+*
+*	 @return
+*	 - unsigned long long :: non-zero key
+*********************************************************************/
+unsigned long long db_key(const Position* pos)
+{
+	unsigned long long key = position_hash(pos);
+	return key ? key : 1;
+}
+/*********************************************************************
+* static void db_merge_entry(Db_Entry* into, const Db_Entry* from)
+*
+* 	PURPOSE ::
+*  		fold a second record of the same position into <into> :
+*  		game counts add up, the deeper analysis wins
+*  			-atomic, the builder threads share slots
+*********************************************************************/
+static void db_merge_entry(Db_Entry* into, const Db_Entry* from)
+{
+	__atomic_fetch_add(&into->games, from->games, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&into->white_wins, from->white_wins, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&into->black_wins, from->black_wins, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&into->draws, from->draws, __ATOMIC_RELAXED);
+
+	if(!(from->flags & DB_FLAG_ANALYSIS))
+		return;
+
+	//score, move and depth travel together in the analysis word
+	unsigned long long ours = __atomic_load_n(&into->analysis, __ATOMIC_RELAXED);
+	for(;;)
+	{
+		Db_Entry current;
+		current.analysis = ours;
+		if((current.flags & DB_FLAG_ANALYSIS) && current.depth > from->depth)
+			return;
+		if(__atomic_compare_exchange_n(&into->analysis, &ours, from->analysis, TRUE,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			return;
+	}
+}
+/*********************************************************************
+* static int db_table_insert(Db_Entry* table, unsigned long long mask,
+*		const Db_Entry* entry)
+*
+* 	PURPOSE ::
+*  		linear-probe <entry> into an open addressed table,
+*  		claiming empty slots with a compare and swap
+*  			-returns TRUE when a new slot was taken
+*********************************************************************/
+static int db_table_insert(Db_Entry* table, unsigned long long mask, const Db_Entry* entry)
+{
+	for(unsigned long long slot = entry->key & mask; ; slot = (slot + 1) & mask)
+	{
+		unsigned long long expected = 0;
+		if(__atomic_compare_exchange_n(&table[slot].key, &expected, entry->key, FALSE,
+					__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+		{
+			db_merge_entry(&table[slot], entry);
+			return TRUE;
+		}
+		if(expected == entry->key)
+		{
+			db_merge_entry(&table[slot], entry);
+			return FALSE;
+		}
+	}
+}
+/*********************************************************************
+* static int db_compare_keys(const void* a, const void* b)
+*
+* 	PURPOSE ::
+*  		qsort / bsearch order for the log overlay
+*********************************************************************/
+static int db_compare_keys(const void* a, const void* b)
+{
+	unsigned long long ka = ((const Db_Entry*)a)->key;
+	unsigned long long kb = ((const Db_Entry*)b)->key;
+	return (ka > kb) - (ka < kb);
+}
+/*********************************************************************
+* static Db_Entry* db_read_log(const char* path, size_t* count,
+*		unsigned long long* generation)
+*
+* 	PURPOSE ::
+*  		read every entry in <path>.log, sorted with duplicate
+*  		keys folded together
+*  			-caller holds the log lock, or does not care
+*  			about appends racing it
+*  			-NULL with *count 0 when there is no log
+*  			-*generation is the log's marker, 0 without one
+*********************************************************************/
+static Db_Entry* db_read_log(const char* path, size_t* count, unsigned long long* generation)
+{
+	char log_path[DB_PATH_MAX + sizeof(DB_LOG_SUFFIX)];
+	snprintf(log_path, sizeof(log_path), "%s%s", path, DB_LOG_SUFFIX);
+	*count = 0;
+	*generation = 0;
+
+	FILE* log = fopen(log_path, "rb");
+	if(!log)
+		return NULL;
+
+	fseek(log, 0, SEEK_END);
+	long bytes = ftell(log);
+	fseek(log, 0, SEEK_SET);
+	size_t total = (bytes > 0) ? (size_t)bytes / sizeof(Db_Entry) : 0;
+	if(total == 0)
+	{
+		fclose(log);
+		return NULL;
+	}
+
+	Db_Entry* entries = (Db_Entry*)malloc(total * sizeof(Db_Entry));
+	if(!entries)
+		error_nomem();
+	total = fread(entries, sizeof(Db_Entry), total, log);
+	fclose(log);
+
+	if(total > 0 && entries[0].key == 0)
+	{
+		Db_Log_Marker marker;
+		memcpy(&marker, &entries[0], sizeof(marker));
+		*generation = marker.generation;
+	}
+
+	qsort(entries, total, sizeof(Db_Entry), db_compare_keys);
+	size_t unique = 0;
+	for(size_t i = 0; i < total; ++i)
+	{
+		//markers sort first and are not positions
+		if(entries[i].key == 0)
+			continue;
+		if(unique > 0 && entries[unique - 1].key == entries[i].key)
+			db_merge_entry(&entries[unique - 1], &entries[i]);
+		else
+			entries[unique++] = entries[i];
+	}
+	*count = unique;
+	return entries;
+}
+/*********************************************************************
+* Position_DB* position_db_open(const char* path)
+*
+* 	PURPOSE ::
+*  		map the database at <path> read only
+*  			-any number of processes may open the same file,
+*  			the kernel shares the pages between them
+*  			-entries waiting in <path>.log are read into a
+*  			small overlay so lookups see them before a merge,
+*  			unless the table says it already holds that log
+*  			-a merge that rebuilds the table replaces the
+*  			file by rename, an open database keeps seeing the
+*  			old one until reopened. A short log is merged in
+*  			place instead, an open database sees each slot as
+*  			it is written and stops adding its overlay once
+*  			the table carries the log's generation
+*
+* 	@param
+*	 - path :: file written by position_db_build()
+*
+*	 @return
+*	 - NULL :: missing or corrupt file
+*	 - db   :: the opened database
+*********************************************************************/
+Position_DB* position_db_open(const char* path)
+{
+	if(!path)
+	{
+		error_noexist("path", "position_db_open");
+		return NULL;
+	}
+
+	int fd = open(path, O_RDONLY);
+	if(fd < 0)
+	{
+		perror("Could not open position database\n\t{position_db_open}\n");
+		return NULL;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Db_Header))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if(map == MAP_FAILED)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	//the mask and every probe trust the header, a foreign or torn
+	//file must not get that far : the capacity has to be a power of
+	//two that fits the file (divided, so it cannot overflow), with
+	//room left for the empty slot that ends a miss
+	const Db_Header* header = (const Db_Header*)map;
+	size_t room = ((size_t)st.st_size - sizeof(Db_Header)) / sizeof(Db_Entry);
+	if(memcmp(header->magic, DB_MAGIC, sizeof(header->magic)) != 0 ||
+	   header->version != DB_VERSION || header->entry_size != sizeof(Db_Entry) ||
+	   header->capacity == 0 || (header->capacity & (header->capacity - 1)) != 0 ||
+	   header->capacity > room || header->count >= header->capacity)
+	{
+		fprintf(stderr, "%s is not a position database\n", path);
+		munmap(map, (size_t)st.st_size);
+		close(fd);
+		return NULL;
+	}
+	//lookups hop around the table, read-ahead would only waste memory
+	madvise(map, (size_t)st.st_size, MADV_RANDOM);
+
+	Position_DB* db = (Position_DB*)calloc(1, sizeof(Position_DB));
+	if(!db)
+		error_nomem();
+	db->fd = fd;
+	db->map = map;
+	db->map_size = (size_t)st.st_size;
+	db->header = header;
+	db->entries = (const Db_Entry*)((const char*)map + sizeof(Db_Header));
+	db->mask = header->capacity - 1;
+
+	unsigned long long generation = 0;
+	db->overlay = db_read_log(path, &db->overlay_count, &generation);
+	if(generation != 0 && generation == header->log_generation)
+	{
+		free(db->overlay);
+		db->overlay = NULL;
+		db->overlay_count = 0;
+	}
+	//what position_db_merge_log() will stamp, a log from before
+	//markers included
+	db->overlay_generation = generation ? generation : header->log_generation + 1;
+	return db;
+}
+/*********************************************************************
+* void position_db_close(Position_DB* db)
+*
+* 	PURPOSE ::
+*  		unmap <db> and free its overlay
+*
+* 	@param
+*	 - db :: database to close
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void position_db_close(Position_DB* db)
+{
+	if(!db)
+		return;
+	munmap(db->map, db->map_size);
+	close(db->fd);
+	free(db->overlay);
+	free(db);
+	return;
+}
+/*********************************************************************
+* int position_db_lookup(const Position_DB* db, unsigned long long key,
+*		Db_Entry* entry)
+*
+* 	PURPOSE ::
+*  		find <key>, straight out of the mapped file
+*  			-unmerged log entries are folded into the result,
+*  			until an in-place merge stamps the table with
+*  			their generation
+*  			-a probe never wraps past the whole table, even
+*  			if the file claims fewer entries than it holds
+*
+* 	@param
+*	 - db    :: opened database
+*	 - key   :: db_key() of the position
+*	 - entry :: receives the record on a hit
+*
+*	 @return
+*	 - TRUE  :: found
+*	 - FALSE :: not in the database
+*********************************************************************/
+int position_db_lookup(const Position_DB* db, unsigned long long key, Db_Entry* entry)
+{
+	int found = FALSE;
+
+	unsigned long long slot = key & db->mask;
+	for(unsigned long long probes = 0; probes <= db->mask; ++probes, slot = (slot + 1) & db->mask)
+	{
+		const Db_Entry* candidate = &db->entries[slot];
+		if(candidate->key == 0)
+			break;
+		if(candidate->key == key)
+		{
+			*entry = *candidate;
+			found = TRUE;
+			break;
+		}
+	}
+
+	if(db->overlay_count &&
+	   __atomic_load_n(&db->header->log_generation, __ATOMIC_ACQUIRE) != db->overlay_generation)
+	{
+		Db_Entry probe = { .key = key };
+		const Db_Entry* logged = (const Db_Entry*)bsearch(&probe, db->overlay,
+				db->overlay_count, sizeof(Db_Entry), db_compare_keys);
+		if(logged)
+		{
+			if(found)
+				db_merge_entry(entry, logged);
+			else
+				*entry = *logged;
+			found = TRUE;
+		}
+	}
+	return found;
+}
+//one builder thread's slice of the input
+typedef struct Db_Insert_Job
+{
+	Db_Entry* table;
+	unsigned long long mask;
+	const Db_Entry* entries;
+	size_t count;
+	size_t added;
+	short started;
+} Db_Insert_Job;
+
+/*********************************************************************
+* static void* db_insert_worker(void* arg)
+*
+* 	PURPOSE ::
+*  		insert one Db_Insert_Job's slice, counting new keys
+*********************************************************************/
+static void* db_insert_worker(void* arg)
+{
+	Db_Insert_Job* job = (Db_Insert_Job*)arg;
+	for(size_t i = 0; i < job->count; ++i)
+		if(job->entries[i].key)
+			job->added += (size_t)db_table_insert(job->table, job->mask, &job->entries[i]);
+	return NULL;
+}
+/*********************************************************************
+* static size_t db_insert_all(Db_Entry* table, unsigned long long mask,
+*		const Db_Entry* entries, size_t count, size_t num_threads)
+*
+* 	PURPOSE ::
+*  		insert <entries> into <table> with <num_threads>
+*  		threads, each taking an equal slice
+*  			-returns how many distinct keys were added
+*********************************************************************/
+static size_t db_insert_all(Db_Entry* table, unsigned long long mask,
+		const Db_Entry* entries, size_t count, size_t num_threads)
+{
+	if(num_threads == 0)
+		num_threads = 1;
+
+	pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+	Db_Insert_Job* jobs = (Db_Insert_Job*)calloc(num_threads, sizeof(Db_Insert_Job));
+	if(!threads || !jobs)
+		error_nomem();
+
+	size_t slice = (count + num_threads - 1) / num_threads;
+	for(size_t t = 0; t < num_threads; ++t)
+	{
+		size_t begin = t * slice;
+		if(begin >= count)
+			break;
+		jobs[t].table = table;
+		jobs[t].mask = mask;
+		jobs[t].entries = entries + begin;
+		jobs[t].count = (begin + slice > count) ? count - begin : slice;
+		jobs[t].started = (pthread_create(&threads[t], NULL, db_insert_worker, &jobs[t]) == 0);
+
+		//no more threads, do this slice here
+		if(!jobs[t].started)
+			db_insert_worker(&jobs[t]);
+	}
+
+	size_t added = 0;
+	for(size_t t = 0; t < num_threads; ++t)
+	{
+		if(jobs[t].started)
+			pthread_join(threads[t], NULL);
+		added += jobs[t].added;
+	}
+
+	free(threads);
+	free(jobs);
+	return added;
+}
+/*********************************************************************
+* static short db_write_table(const char* path, const Db_Entry* base,
+*		unsigned long long base_capacity, size_t base_count,
+*		const Db_Entry* entries, size_t count, size_t num_threads,
+*		unsigned long long log_generation)
+*
+* 	PURPOSE ::
+*  		write a new table holding the occupied slots of <base>
+*  		(may be NULL) plus <entries> to <path>.tmp, stamped
+*  		with <log_generation>, then rename it over <path>
+*  			-the table is built inside a shared mapping of
+*  			the new file, so it never has to fit in RAM
+*********************************************************************/
+static short db_write_table(const char* path, const Db_Entry* base,
+		unsigned long long base_capacity, size_t base_count,
+		const Db_Entry* entries, size_t count, size_t num_threads,
+		unsigned long long log_generation)
+{
+	char tmp_path[DB_PATH_MAX + sizeof(DB_TMP_SUFFIX)];
+	snprintf(tmp_path, sizeof(tmp_path), "%s%s", path, DB_TMP_SUFFIX);
+
+	unsigned long long capacity = 16;
+	while(capacity < (base_count + count) * DB_LOAD_FACTOR)
+		capacity <<= 1;
+	size_t file_size = sizeof(Db_Header) + capacity * sizeof(Db_Entry);
+
+	int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+	{
+		perror("Could not create position database\n\t{db_write_table}\n");
+		return FAILURE;
+	}
+	if(ftruncate(fd, (off_t)file_size) != 0)
+	{
+		close(fd);
+		unlink(tmp_path);
+		return FAILURE;
+	}
+	void* map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(map == MAP_FAILED)
+	{
+		close(fd);
+		unlink(tmp_path);
+		return FAILURE;
+	}
+
+	Db_Entry* table = (Db_Entry*)((char*)map + sizeof(Db_Header));
+	unsigned long long mask = capacity - 1;
+	size_t added = 0;
+	for(unsigned long long slot = 0; base && slot < base_capacity; ++slot)
+		if(base[slot].key)
+			added += (size_t)db_table_insert(table, mask, &base[slot]);
+	added += db_insert_all(table, mask, entries, count, num_threads);
+
+	Db_Header* header = (Db_Header*)map;
+	memcpy(header->magic, DB_MAGIC, sizeof(header->magic));
+	header->version = DB_VERSION;
+	header->entry_size = sizeof(Db_Entry);
+	header->capacity = capacity;
+	header->count = added;
+	header->log_generation = log_generation;
+
+	short status = 0;
+	if(msync(map, file_size, MS_SYNC) != 0)
+		status = FAILURE;
+	munmap(map, file_size);
+	close(fd);
+
+	//readers either see the whole old file or the whole new one
+	if(status == 0 && rename(tmp_path, path) != 0)
+		status = FAILURE;
+	if(status != 0)
+		unlink(tmp_path);
+	return status;
+}
+/*********************************************************************
+* short position_db_build(const char* path, const Db_Entry* entries,
+*		size_t count, size_t num_threads)
+*
+* 	PURPOSE ::
+*  		write a fresh database at <path> from <entries>
+*  			-records sharing a key are folded together
+*
+* 	@param
+*	 - path        :: file to (re)create
+*	 - entries     :: records, key filled in with db_key()
+*	 - count       :: number of records
+*	 - num_threads :: inserting threads
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: could not write the file
+*********************************************************************/
+short position_db_build(const char* path, const Db_Entry* entries, size_t count,
+		size_t num_threads)
+{
+	if(!path || (!entries && count))
+	{
+		error_noexist("entries", "position_db_build");
+		return FAILURE;
+	}
+	return db_write_table(path, NULL, 0, 0, entries, count, num_threads, 0);
+}
+/*********************************************************************
+* static short db_parse_epd(const char* line, Db_Entry* entry)
+*
+* 	PURPOSE ::
+*  		turn one EPD line into a record, understood opcodes are
+*  			ce  <centipawns>
+*  			bm  <coordinate move>
+*  			acd <depth>
+*  			res <1-0 | 0-1 | 1/2-1/2>
+*********************************************************************/
+static short db_parse_epd(const char* line, Db_Entry* entry)
+{
+	Position pos;
+	if(position_from_fen(&pos, line) != 0)
+		return FAILURE;
+
+	memset(entry, 0, sizeof(*entry));
+	entry->key = db_key(&pos);
+
+	char copy[512];
+	snprintf(copy, sizeof(copy), "%s", line);
+
+	//skip the board, side, castling and en passant fields
+	char* save = NULL;
+	char* token = strtok_r(copy, " \t", &save);
+	for(size_t field = 1; token && field < 4; ++field)
+		token = strtok_r(NULL, " \t", &save);
+
+	const char* delims = " \t;\"\r\n";
+	while((token = strtok_r(NULL, delims, &save)))
+	{
+		if(strcmp(token, "ce") == 0 && (token = strtok_r(NULL, delims, &save)))
+		{
+			entry->score = (short)atoi(token);
+			entry->flags |= DB_FLAG_ANALYSIS;
+		}
+		else if(strcmp(token, "acd") == 0 && (token = strtok_r(NULL, delims, &save)))
+		{
+			entry->depth = (unsigned short)atoi(token);
+			entry->flags |= DB_FLAG_ANALYSIS;
+		}
+		else if(strcmp(token, "bm") == 0 && (token = strtok_r(NULL, delims, &save)))
+		{
+			Move move;
+			if(move_from_coord(token, &move) == 0)
+			{
+				entry->best_move = move_pack(move);
+				entry->flags |= DB_FLAG_ANALYSIS;
+			}
+		}
+		else if(strcmp(token, "res") == 0 && (token = strtok_r(NULL, delims, &save)))
+		{
+			entry->games = 1;
+			if(strcmp(token, "1-0") == 0)
+				entry->white_wins = 1;
+			else if(strcmp(token, "0-1") == 0)
+				entry->black_wins = 1;
+			else
+				entry->draws = 1;
+		}
+		if(!token)
+			break;
+	}
+	return 0;
+}
+/*********************************************************************
+* short position_db_build_epd(const char* path, const char* epd_path,
+*		size_t num_threads)
+*
+* 	PURPOSE ::
+*  		position_db_build() from an EPD (or plain FEN) file,
+*  		one position per line
+*  			-lines that do not parse are skipped
+*
+* 	@param
+*	 - path        :: database file to (re)create
+*	 - epd_path    :: input, see db_parse_epd() for opcodes
+*	 - num_threads :: inserting threads
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: could not read the input or write the file
+*********************************************************************/
+short position_db_build_epd(const char* path, const char* epd_path, size_t num_threads)
+{
+	FILE* epd = fopen(epd_path, "r");
+	if(!epd)
+	{
+		perror("Could not open EPD file\n\t{position_db_build_epd}\n");
+		return FAILURE;
+	}
+
+	size_t count = 0;
+	size_t capacity = 1024;
+	Db_Entry* entries = (Db_Entry*)malloc(capacity * sizeof(Db_Entry));
+	if(!entries)
+		error_nomem();
+
+	char line[512];
+	size_t skipped = 0;
+	while(fgets(line, sizeof(line), epd))
+	{
+		if(line[0] == '\n' || line[0] == '#')
+			continue;
+		if(count == capacity)
+		{
+			capacity *= 2;
+			entries = (Db_Entry*)realloc(entries, capacity * sizeof(Db_Entry));
+			if(!entries)
+				error_nomem();
+		}
+		if(db_parse_epd(line, &entries[count]) == 0)
+			count++;
+		else
+			skipped++;
+	}
+	fclose(epd);
+
+	if(skipped)
+		fprintf(stderr, "Skipped %zu malformed lines in %s\n", skipped, epd_path);
+
+	short status = position_db_build(path, entries, count, num_threads);
+	free(entries);
+	return status;
+}
+/*********************************************************************
+* static int db_lock_log(const char* path, int operation)
+*
+* 	PURPOSE ::
+*  		open <path>.log and flock it, shared by every process
+*  		appending to or merging the same database
+*  			-returns the descriptor, or -1
+*********************************************************************/
+static int db_lock_log(const char* path, int operation)
+{
+	char log_path[DB_PATH_MAX + sizeof(DB_LOG_SUFFIX)];
+	snprintf(log_path, sizeof(log_path), "%s%s", path, DB_LOG_SUFFIX);
+
+	int fd = open(log_path, O_RDWR | O_CREAT | O_APPEND, 0644);
+	if(fd < 0)
+		return -1;
+	if(flock(fd, operation) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+/*********************************************************************
+* static short db_write_all(int fd, const void* data, size_t bytes)
+*
+* 	PURPOSE ::
+*  		write(), retried until every byte is out
+*********************************************************************/
+static short db_write_all(int fd, const void* data, size_t bytes)
+{
+	const char* next = (const char*)data;
+	while(bytes > 0)
+	{
+		ssize_t written = write(fd, next, bytes);
+		if(written < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			return FAILURE;
+		}
+		next += written;
+		bytes -= (size_t)written;
+	}
+	return 0;
+}
+/*********************************************************************
+* static short db_pwrite_all(int fd, const void* data, size_t bytes,
+*		off_t offset)
+*
+* 	PURPOSE ::
+*  		pwrite(), retried until every byte is out
+*********************************************************************/
+static short db_pwrite_all(int fd, const void* data, size_t bytes, off_t offset)
+{
+	const char* next = (const char*)data;
+	while(bytes > 0)
+	{
+		ssize_t written = pwrite(fd, next, bytes, offset);
+		if(written < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			return FAILURE;
+		}
+		next += written;
+		offset += written;
+		bytes -= (size_t)written;
+	}
+	return 0;
+}
+/*********************************************************************
+* static short db_start_log(const char* path, int fd)
+*
+* 	PURPOSE ::
+*  		write the marker of an empty, locked log : one past the
+*  		generation the table at <path> last merged, so the two
+*  		can only match once this log is merged
+*********************************************************************/
+static short db_start_log(const char* path, int fd)
+{
+	Db_Log_Marker marker;
+	memset(&marker, 0, sizeof(marker));
+
+	Db_Header header;
+	int table = open(path, O_RDONLY);
+	if(table >= 0)
+	{
+		if(pread(table, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+		   memcmp(header.magic, DB_MAGIC, sizeof(header.magic)) == 0)
+			marker.generation = header.log_generation;
+		close(table);
+	}
+	marker.generation++;
+	return db_write_all(fd, &marker, sizeof(marker));
+}
+/*********************************************************************
+* short position_db_append(const char* path, const Db_Entry* entries,
+*		size_t count)
+*
+* 	PURPOSE ::
+*  		add records without rebuilding : they go to <path>.log
+*  		and into the table at the next merge
+*
+* 	@param
+*	 - path    :: database file
+*	 - entries :: records, key filled in with db_key()
+*	 - count   :: number of records
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: could not write the log
+*********************************************************************/
+short position_db_append(const char* path, const Db_Entry* entries, size_t count)
+{
+	int fd = db_lock_log(path, LOCK_EX);
+	if(fd < 0)
+	{
+		perror("Could not open database log\n\t{position_db_append}\n");
+		return FAILURE;
+	}
+
+	short status = 0;
+	struct stat st;
+	if(fstat(fd, &st) != 0 || (st.st_size == 0 && db_start_log(path, fd) != 0))
+		status = FAILURE;
+	if(status == 0)
+		status = db_write_all(fd, entries, count * sizeof(Db_Entry));
+
+	flock(fd, LOCK_UN);
+	close(fd);
+	return status;
+}
+/*********************************************************************
+* static short db_undo_merge(const char* path)
+*
+* 	PURPOSE ::
+*  		roll back an in-place merge that died half way, from
+*  		<path>.undo, so its log can be merged again
+*  			-the undo file is on disk before the table is
+*  			touched, a torn one means the table never was,
+*  			and putting back what it does hold is harmless
+*  			-caller holds the log lock
+*********************************************************************/
+static short db_undo_merge(const char* path)
+{
+	char undo_path[DB_PATH_MAX + sizeof(DB_UNDO_SUFFIX)];
+	snprintf(undo_path, sizeof(undo_path), "%s%s", path, DB_UNDO_SUFFIX);
+
+	int undo = open(undo_path, O_RDONLY);
+	if(undo < 0)
+		return (errno == ENOENT) ? 0 : FAILURE;
+
+	short status = 0;
+	Db_Header header;
+	if(pread(undo, &header, sizeof(header), 0) == (ssize_t)sizeof(header))
+	{
+		int table = open(path, O_RDWR);
+		if(table < 0)
+			status = FAILURE;
+		off_t offset = sizeof(header);
+		Db_Undo_Record record;
+		while(status == 0 &&
+		      pread(undo, &record, sizeof(record), offset) == (ssize_t)sizeof(record))
+		{
+			offset += sizeof(record);
+			if(record.slot >= header.capacity)
+				continue;
+			status = db_pwrite_all(table, &record.entry, sizeof(record.entry),
+					(off_t)(sizeof(Db_Header) + record.slot * sizeof(Db_Entry)));
+		}
+		if(status == 0)
+			status = db_pwrite_all(table, &header, sizeof(header), 0);
+		if(status == 0 && fsync(table) != 0)
+			status = FAILURE;
+		if(table >= 0)
+			close(table);
+	}
+	close(undo);
+
+	if(status == 0)
+		unlink(undo_path);
+	return status;
+}
+/*********************************************************************
+* static size_t* db_touched_find(size_t* touched, size_t mask,
+*		unsigned long long slot, const Db_Undo_Record* undo)
+*
+* 	PURPOSE ::
+*  		the entry of <touched> (an open addressed index into
+*  		<undo>, 0 empty, else index + 1) for <slot>, or the
+*  		empty one it would go in
+*********************************************************************/
+static size_t* db_touched_find(size_t* touched, size_t mask, unsigned long long slot,
+		const Db_Undo_Record* undo)
+{
+	for(size_t at = (size_t)slot & mask; ; at = (at + 1) & mask)
+		if(touched[at] == 0 || undo[touched[at] - 1].slot == slot)
+			return &touched[at];
+}
+/*********************************************************************
+* static short db_merge_in_place(const char* path,
+*		const Position_DB* db, const Db_Entry* logged, size_t count,
+*		unsigned long long generation)
+*
+* 	PURPOSE ::
+*  		fold <logged> into the table at <path> by rewriting
+*  		only the slots it lands in, stamped with <generation>
+*  			-the slots' old contents go to <path>.undo and to
+*  			disk first, db_undo_merge() puts them back if
+*  			this dies before the table is synced
+*  			-the header goes first, open databases then drop
+*  			their overlay and briefly miss what is still to
+*  			come rather than count it twice
+*  			-caller holds the log lock and has checked the
+*  			table has room for every key in <logged>
+*********************************************************************/
+static short db_merge_in_place(const char* path, const Position_DB* db,
+		const Db_Entry* logged, size_t count, unsigned long long generation)
+{
+	size_t touched_size = 16;
+	while(touched_size < count * 2)
+		touched_size <<= 1;
+	size_t* touched = (size_t*)calloc(touched_size, sizeof(size_t));
+	Db_Undo_Record* undo = (Db_Undo_Record*)malloc(count * sizeof(Db_Undo_Record));
+	Db_Entry* fresh = (Db_Entry*)malloc(count * sizeof(Db_Entry));
+	if(!touched || !undo || !fresh)
+		error_nomem();
+
+	//work out every slot's new contents before writing any
+	size_t num_touched = 0;
+	size_t added = 0;
+	for(size_t i = 0; i < count; ++i)
+	{
+		unsigned long long slot = logged[i].key & db->mask;
+		for(unsigned long long probes = 0; probes <= db->mask; ++probes, slot = (slot + 1) & db->mask)
+		{
+			size_t* found = db_touched_find(touched, touched_size - 1, slot, undo);
+			const Db_Entry* current = *found ? &fresh[*found - 1] : &db->entries[slot];
+			if(current->key != 0 && current->key != logged[i].key)
+				continue;
+			if(*found == 0)
+			{
+				undo[num_touched].slot = slot;
+				undo[num_touched].entry = *current;
+				fresh[num_touched] = *current;
+				*found = ++num_touched;
+			}
+			Db_Entry* entry = &fresh[*found - 1];
+			if(entry->key == 0)
+			{
+				entry->key = logged[i].key;
+				added++;
+			}
+			db_merge_entry(entry, &logged[i]);
+			break;
+		}
+	}
+
+	Db_Header header = *db->header;
+	header.count += added;
+	header.log_generation = generation;
+
+	char undo_path[DB_PATH_MAX + sizeof(DB_UNDO_SUFFIX)];
+	snprintf(undo_path, sizeof(undo_path), "%s%s", path, DB_UNDO_SUFFIX);
+	short status = 0;
+	int undo_fd = open(undo_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(undo_fd < 0 || db_write_all(undo_fd, db->header, sizeof(Db_Header)) != 0 ||
+	   db_write_all(undo_fd, undo, num_touched * sizeof(Db_Undo_Record)) != 0 ||
+	   fsync(undo_fd) != 0)
+		status = FAILURE;
+	if(undo_fd >= 0)
+		close(undo_fd);
+
+	int table = -1;
+	if(status == 0 && (table = open(path, O_RDWR)) < 0)
+		status = FAILURE;
+	if(status == 0)
+		status = db_pwrite_all(table, &header, sizeof(header), 0);
+	for(size_t i = 0; status == 0 && i < num_touched; ++i)
+		status = db_pwrite_all(table, &fresh[i], sizeof(Db_Entry),
+				(off_t)(sizeof(Db_Header) + undo[i].slot * sizeof(Db_Entry)));
+	if(status == 0 && fsync(table) != 0)
+		status = FAILURE;
+	if(table >= 0)
+		close(table);
+
+	//a table that took some of the writes is rolled back by the next
+	//merge, one that took none has nothing to undo
+	if(status == 0 || table < 0)
+		unlink(undo_path);
+
+	free(fresh);
+	free(undo);
+	free(touched);
+	return status;
+}
+/*********************************************************************
+* short position_db_merge_log(const char* path)
+*
+* 	PURPOSE ::
+*  		fold <path>.log into the table and empty the log
+*  			-the log stays locked throughout, appends wait
+*  			instead of getting lost
+*  			-a log short enough to fit goes into the table in
+*  			place, rewriting only the slots it touches, a
+*  			longer one rebuilds the table at a size that fits
+*  			-the table carries the log's generation, so a
+*  			merge that dies after updating it but before
+*  			emptying the log is not replayed by the next one.
+*  			An in-place merge that dies half way is rolled
+*  			back by the next one before it starts
+*
+* 	@param
+*	 - path :: database file
+*
+*	 @return
+*	 - 0       :: success (also when the log was empty)
+*	 - FAILURE :: could not update the file, or roll back the
+*	 	      last merge
+*********************************************************************/
+short position_db_merge_log(const char* path)
+{
+	int lock = db_lock_log(path, LOCK_EX);
+	if(lock < 0)
+		return FAILURE;
+
+	size_t count = 0;
+	unsigned long long generation = 0;
+	Db_Entry* logged = NULL;
+	short status = db_undo_merge(path);
+	if(status == 0)
+		logged = db_read_log(path, &count, &generation);
+
+	if(count > 0)
+	{
+		Position_DB* db = position_db_open(path);
+		unsigned long long merged = db ? db->header->log_generation : 0;
+		//a log from before markers still gets a generation of its own
+		if(generation == 0)
+			generation = merged + 1;
+
+		//the table already holds this log, only emptying it is left
+		if(!db)
+			status = db_write_table(path, NULL, 0, 0, logged, count, 1, generation);
+		else if(generation != merged)
+		{
+			const Db_Header* header = db->header;
+			if((header->count + count) * DB_LOAD_FACTOR <= header->capacity &&
+			   count * DB_IN_PLACE_RATIO <= header->capacity)
+				status = db_merge_in_place(path, db, logged, count, generation);
+			else
+				status = db_write_table(path, db->entries, header->capacity,
+						(size_t)header->count, logged, count, 1, generation);
+		}
+		position_db_close(db);
+
+		//emptied first, a crash before the new marker leaves an empty
+		//log that the next append starts afresh
+		if(status == 0 && ftruncate(lock, 0) != 0)
+			status = FAILURE;
+		if(status == 0)
+			db_start_log(path, lock);
+	}
+
+	free(logged);
+	flock(lock, LOCK_UN);
+	close(lock);
+	return status;
+}
+/*********************************************************************
+* static void* db_merger_loop(void* arg)
+*
+* 	PURPOSE ::
+*  		wake every interval_ms and merge once the log has
+*  		grown past min_log_entries
+*********************************************************************/
+static void* db_merger_loop(void* arg)
+{
+	Db_Merger* merger = (Db_Merger*)arg;
+	char log_path[DB_PATH_MAX + sizeof(DB_LOG_SUFFIX)];
+	snprintf(log_path, sizeof(log_path), "%s%s", merger->path, DB_LOG_SUFFIX);
+
+	while(__atomic_load_n(&merger->running, __ATOMIC_ACQUIRE))
+	{
+		struct stat st;
+		if(stat(log_path, &st) == 0 &&
+		   (size_t)st.st_size / sizeof(Db_Entry) >= merger->min_log_entries &&
+		   st.st_size > 0)
+			position_db_merge_log(merger->path);
+
+		//sleep in short steps so stopping stays quick
+		for(unsigned long long slept = 0; slept < merger->interval_ms &&
+				__atomic_load_n(&merger->running, __ATOMIC_ACQUIRE); slept += 10)
+		{
+			struct timespec nap = { 0, 10 * 1000000L };
+			nanosleep(&nap, NULL);
+		}
+	}
+	return NULL;
+}
+/*********************************************************************
+* Db_Merger* position_db_start_merger(const char* path,
+*		unsigned long long interval_ms, size_t min_log_entries)
+*
+* 	PURPOSE ::
+*  		start a background thread merging <path>.log
+*
+* 	@param
+*	 - path            :: database file
+*	 - interval_ms     :: how often to look at the log
+*	 - min_log_entries :: merge only past this many records
+*
+*	 @return
+*	 - NULL   :: on failure
+*	 - merger :: pass to position_db_stop_merger()
+*********************************************************************/
+Db_Merger* position_db_start_merger(const char* path, unsigned long long interval_ms,
+		size_t min_log_entries)
+{
+	Db_Merger* merger = (Db_Merger*)calloc(1, sizeof(Db_Merger));
+	if(!merger)
+		return NULL;
+
+	snprintf(merger->path, sizeof(merger->path), "%s", path);
+	merger->interval_ms = interval_ms ? interval_ms : 1000;
+	merger->min_log_entries = min_log_entries ? min_log_entries : 1;
+	merger->running = TRUE;
+	if(pthread_create(&merger->thread, NULL, db_merger_loop, merger) != 0)
+	{
+		free(merger);
+		return NULL;
+	}
+	return merger;
+}
+/*********************************************************************
+* void position_db_stop_merger(Db_Merger* merger)
+*
+* 	PURPOSE ::
+*  		stop the merge thread, letting a merge in progress finish
+*
+* 	@param
+*	 - merger :: from position_db_start_merger()
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void position_db_stop_merger(Db_Merger* merger)
+{
+	if(!merger)
+		return;
+	__atomic_store_n(&merger->running, FALSE, __ATOMIC_RELEASE);
+	pthread_join(merger->thread, NULL);
+	free(merger);
+	return;
+}
+#endif //POSITION_DB_IMPLEMENTATION_
+#endif //POSITION_DB_H_
@@ -0,0 +1,230 @@
+#ifndef POSITION_PACK_H_
+#define POSITION_PACK_H_
+
+///user defined
+#include "position.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define MAX_PIECES 32
+
+//a full game state in 32 bytes :
+//a bit per occupied square, then one nibble per occupant in square order
+//(bit 3 set for black, low bits 1..6 for P N B R Q K)
+typedef struct Packed_Position
+{
+	unsigned long long occupancy;
+	unsigned char pieces[MAX_PIECES / 2];
+	unsigned char side;		//0 white, 1 black
+	unsigned char reserved;
+	unsigned short halfmove;
+	unsigned short fullmove;
+	unsigned char padding[2];
+} Packed_Position;
+
+short position_pack(const Position* pos, Packed_Position* packed);
+short position_unpack(const Packed_Position* packed, Position* pos);
+size_t position_pack_bulk(const Position* positions, Packed_Position* packed, size_t count,
+		short* status);
+size_t position_unpack_bulk(const Packed_Position* packed, Position* positions, size_t count,
+		short* status);
+
+#ifdef POSITION_PACK_IMPLEMENTATION_
+
+_Static_assert(sizeof(Packed_Position) == 32, "Packed_Position must stay 32 bytes");
+
+//piece letter -> nibble, 0 for anything that is not a piece
+static const unsigned char PACK_CODE[256] = {
+	['P'] = 1, ['N'] = 2, ['B'] = 3, ['R'] = 4, ['Q'] = 5, ['K'] = 6,
+	['p'] = 9, ['n'] = 10, ['b'] = 11, ['r'] = 12, ['q'] = 13, ['k'] = 14
+};
+//nibble -> piece letter
+static const char PACK_PIECE[16] = {
+	'.', 'P', 'N', 'B', 'R', 'Q', 'K', '.',
+	'.', 'p', 'n', 'b', 'r', 'q', 'k', '.'
+};
+
+/*********************************************************************
+* static unsigned long long pack_occupancy(const Position* pos)
+*
+* 	PURPOSE ::
+*  		bit per square that is not '.'
+*  			-16 squares per compare when SSE2 is there
+*********************************************************************/
+static unsigned long long pack_occupancy(const Position* pos)
+{
+	const unsigned char* squares = (const unsigned char*)pos->squares;
+	unsigned long long occupancy = 0;
+#ifdef __SSE2__
+	const __m128i empty = _mm_set1_epi8('.');
+	for(size_t i = 0; i < NUM_ROWS * NUM_COLS; i += 16)
+	{
+		__m128i chunk = _mm_loadu_si128((const __m128i*)(squares + i));
+		unsigned long long is_empty = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, empty));
+		occupancy |= (~is_empty & 0xFFFFULL) << i;
+	}
+#else
+	for(size_t i = 0; i < NUM_ROWS * NUM_COLS; ++i)
+		occupancy |= (unsigned long long)(squares[i] != '.') << i;
+#endif
+	return occupancy;
+}
+/*********************************************************************
+* short position_pack(const Position* pos, Packed_Position* packed)
+*
+* 	PURPOSE ::
+*  		encode <pos> into 32 bytes
+*
+* 	@param
+*	 - pos    :: the position to encode
+*	 - packed :: overwritten with the encoding
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: more than MAX_PIECES pieces, or a square
+*	 	      holding something that is not a piece
+*********************************************************************/
+short position_pack(const Position* pos, Packed_Position* packed)
+{
+	const unsigned char* squares = (const unsigned char*)pos->squares;
+	unsigned long long occupancy = pack_occupancy(pos);
+	if(__builtin_popcountll(occupancy) > MAX_PIECES)
+		return FAILURE;
+
+	memset(packed, 0, sizeof(*packed));
+	packed->occupancy = occupancy;
+
+	size_t nibble = 0;
+	for(unsigned long long bits = occupancy; bits; bits &= bits - 1, ++nibble)
+	{
+		unsigned char code = PACK_CODE[squares[__builtin_ctzll(bits)]];
+		if(!code)
+			return FAILURE;
+		packed->pieces[nibble >> 1] |= (unsigned char)(code << ((nibble & 1) * 4));
+	}
+
+	packed->side = (pos->side == BLACK);
+	packed->halfmove = pos->halfmove;
+	packed->fullmove = pos->fullmove;
+	return 0;
+}
+/*********************************************************************
+* short position_unpack(const Packed_Position* packed, Position* pos)
+*
+* 	PURPOSE ::
+*  		decode a position written by position_pack()
+*
+* 	@param
+*	 - packed :: the encoding
+*	 - pos    :: overwritten with the position
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: <packed> is corrupt
+*********************************************************************/
+short position_unpack(const Packed_Position* packed, Position* pos)
+{
+	if(__builtin_popcountll(packed->occupancy) > MAX_PIECES)
+		return FAILURE;
+
+	char* squares = (char*)pos->squares;
+	memset(squares, '.', NUM_ROWS * NUM_COLS);
+
+	size_t nibble = 0;
+	for(unsigned long long bits = packed->occupancy; bits; bits &= bits - 1, ++nibble)
+	{
+		unsigned char code = (packed->pieces[nibble >> 1] >> ((nibble & 1) * 4)) & 0xF;
+		if(PACK_PIECE[code] == '.')
+			return FAILURE;
+		squares[__builtin_ctzll(bits)] = PACK_PIECE[code];
+	}
+
+	pos->side = packed->side ? BLACK : WHITE;
+	pos->halfmove = packed->halfmove;
+	pos->fullmove = packed->fullmove;
+	return 0;
+}
+/*********************************************************************
+* size_t position_pack_bulk(const Position* positions,
+*		Packed_Position* packed, size_t count, short* status)
+*
+* 	PURPOSE ::
+*  		position_pack() over an array, nothing more
+*  			-a position that cannot be encoded leaves its
+*  			slot zeroed, <status> says which ones those are
+*
+* 	@param
+*	 - positions :: <count> positions
+*	 - packed    :: <count> slots for the encodings
+*	 - count     :: array length
+*	 - status    :: <count> results, 0 or FAILURE per slot,
+*	 	        NULL when only the total matters
+*
+*	 @return
+*	 - size_t :: how many were encoded
+*********************************************************************/
+size_t position_pack_bulk(const Position* positions, Packed_Position* packed, size_t count,
+		short* status)
+{
+	size_t done = 0;
+	for(size_t i = 0; i < count; ++i)
+	{
+		short result = position_pack(&positions[i], &packed[i]);
+		if(result == 0)
+			done++;
+		else
+			memset(&packed[i], 0, sizeof(Packed_Position));
+		if(status)
+			status[i] = result;
+	}
+	return done;
+}
+/*********************************************************************
+* size_t position_unpack_bulk(const Packed_Position* packed,
+*		Position* positions, size_t count, short* status)
+*
+* 	PURPOSE ::
+*  		position_unpack() over an array, nothing more
+*  			-a corrupt slot comes back as an empty board,
+*  			white to move, clocks 0 and 1, and FAILURE in
+*  			<status>
+*
+* 	@param
+*	 - packed    :: <count> encodings
+*	 - positions :: <count> slots for the positions
+*	 - count     :: array length
+*	 - status    :: <count> results, 0 or FAILURE per slot,
+*	 	        NULL when only the total matters
+*
+*	 @return
+*	 - size_t :: how many were decoded
+*********************************************************************/
+size_t position_unpack_bulk(const Packed_Position* packed, Position* positions, size_t count,
+		short* status)
+{
+	size_t done = 0;
+	for(size_t i = 0; i < count; ++i)
+	{
+		short result = position_unpack(&packed[i], &positions[i]);
+		if(result == 0)
+			done++;
+		else
+		{
+			memset(positions[i].squares, '.', sizeof(positions[i].squares));
+			positions[i].side = WHITE;
+			positions[i].halfmove = 0;
+			positions[i].fullmove = 1;
+		}
+		if(status)
+			status[i] = result;
+	}
+	return done;
+}
+#endif //POSITION_PACK_IMPLEMENTATION_
+#endif //POSITION_PACK_H_
@@ -0,0 +1,191 @@
+#ifndef RING_QUEUE_H_
+#define RING_QUEUE_H_
+
+///user defined
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE 64
+
+//bounded multi-producer / multi-consumer queue,
+//each cell carries a sequence number so pushes and pops
+//only ever contend on a single atomic counter
+typedef struct Ring_Queue
+{
+	unsigned char* cells;
+	size_t cell_size;
+	size_t elem_size;
+	size_t mask;
+
+	_Alignas(CACHE_LINE) atomic_size_t head;
+	_Alignas(CACHE_LINE) atomic_size_t tail;
+} Ring_Queue;
+
+short ring_queue_init(Ring_Queue* queue, size_t capacity, size_t elem_size);
+void ring_queue_free(Ring_Queue* queue);
+short ring_queue_push(Ring_Queue* queue, const void* elem);
+short ring_queue_pop(Ring_Queue* queue, void* elem);
+
+#ifdef RING_QUEUE_IMPLEMENTATION_
+
+//the sequence number sits at the front of every cell
+#define RING_CELL(queue, pos) ((queue)->cells + ((pos) & (queue)->mask) * (queue)->cell_size)
+#define RING_SEQ(cell) ((atomic_size_t*)(cell))
+#define RING_DATA(cell) ((cell) + sizeof(atomic_size_t))
+
+/*********************************************************************
+* short ring_queue_init(Ring_Queue* queue, size_t capacity, size_t elem_size)
+*
+* 	PURPOSE ::
+*  		allocate the cells of <queue>
+*  			-<capacity> is rounded up to a power of two
+*
+* 	@param
+*	 - queue     :: queue to set up
+*	 - capacity  :: how many elements it can hold at once
+*	 - elem_size :: sizeof one element, copied in and out
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: bad arguments or no memory
+*********************************************************************/
+short ring_queue_init(Ring_Queue* queue, size_t capacity, size_t elem_size)
+{
+	if(!queue)
+	{
+		error_noexist("queue", "ring_queue_init");
+		return FAILURE;
+	}
+	if(capacity < 2 || elem_size == 0)
+	{
+		fprintf(stderr, "Capacity and element size must be non-zero!\n");
+		return FAILURE;
+	}
+
+	size_t size = 2;
+	while(size < capacity)
+		size <<= 1;
+
+	//keep every element aligned like the sequence counter
+	size_t cell_size = sizeof(atomic_size_t) + elem_size;
+	cell_size = (cell_size + sizeof(atomic_size_t) - 1) & ~(sizeof(atomic_size_t) - 1);
+
+	queue->cells = (unsigned char*)malloc(size * cell_size);
+	if(!queue->cells)
+		return FAILURE;
+
+	queue->cell_size = cell_size;
+	queue->elem_size = elem_size;
+	queue->mask = size - 1;
+	for(size_t i = 0; i < size; ++i)
+		atomic_init(RING_SEQ(RING_CELL(queue, i)), i);
+	atomic_init(&queue->head, 0);
+	atomic_init(&queue->tail, 0);
+	return 0;
+}
+/*********************************************************************
+* void ring_queue_free(Ring_Queue* queue)
+*
+* 	PURPOSE ::
+*  		release the cells of <queue>
+*  			-no thread may be pushing or popping
+*
+* 	@param
+*	 - queue :: queue to tear down
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void ring_queue_free(Ring_Queue* queue)
+{
+	if(!queue)
+		return;
+	free(queue->cells);
+	queue->cells = NULL;
+	return;
+}
+/*********************************************************************
+* short ring_queue_push(Ring_Queue* queue, const void* elem)
+*
+* 	PURPOSE ::
+*  		copy <elem> onto the back of <queue> without locking
+*
+* 	@param
+*	 - queue :: destination queue
+*	 - elem  :: points at elem_size bytes to copy in
+*
+*	 @return
+*	 - TRUE  :: pushed
+*	 - FALSE :: queue is full, try again later
+*********************************************************************/
+short ring_queue_push(Ring_Queue* queue, const void* elem)
+{
+	size_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	for(;;)
+	{
+		unsigned char* cell = RING_CELL(queue, pos);
+		size_t seq = atomic_load_explicit(RING_SEQ(cell), memory_order_acquire);
+		ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+
+		if(diff == 0)
+		{
+			if(atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1,
+						memory_order_relaxed, memory_order_relaxed))
+			{
+				memcpy(RING_DATA(cell), elem, queue->elem_size);
+				atomic_store_explicit(RING_SEQ(cell), pos + 1, memory_order_release);
+				return TRUE;
+			}
+		}
+		else if(diff < 0)
+			return FALSE;
+		else
+			pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	}
+}
+/*********************************************************************
+* short ring_queue_pop(Ring_Queue* queue, void* elem)
+*
+* 	PURPOSE ::
+*  		copy the front of <queue> into <elem> without locking
+*
+* 	@param
+*	 - queue :: source queue
+*	 - elem  :: receives elem_size bytes
+*
+*	 @return
+*	 - TRUE  :: popped
+*	 - FALSE :: queue is empty
+*********************************************************************/
+short ring_queue_pop(Ring_Queue* queue, void* elem)
+{
+	size_t pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	for(;;)
+	{
+		unsigned char* cell = RING_CELL(queue, pos);
+		size_t seq = atomic_load_explicit(RING_SEQ(cell), memory_order_acquire);
+		ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+
+		if(diff == 0)
+		{
+			if(atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1,
+						memory_order_relaxed, memory_order_relaxed))
+			{
+				memcpy(elem, RING_DATA(cell), queue->elem_size);
+				atomic_store_explicit(RING_SEQ(cell), pos + queue->mask + 1, memory_order_release);
+				return TRUE;
+			}
+		}
+		else if(diff < 0)
+			return FALSE;
+		else
+			pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	}
+}
+#endif //RING_QUEUE_IMPLEMENTATION_
+#endif //RING_QUEUE_H_
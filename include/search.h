@@ -0,0 +1,576 @@
+#ifndef SEARCH_H_
+#define SEARCH_H_
+
+///user defined
+#include "position.h"
+#include "move_gen.h"
+#include "zobrist.h"
+#include "eval.h"
+#include "tt.h"
+#include "time_manager.h"
+#include "stats.h"
+#include "arena.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAX_PLY 64
+#define MATE_SCORE 30000
+//anything past this is a forced king capture
+#define MATE_BOUND (MATE_SCORE - MAX_PLY)
+#define INFINITE_SCORE 32000
+//most root lines one search reports
+#define MAX_MULTIPV 8
+
+typedef struct Search_Limits
+{
+	int depth;			//0 for MAX_PLY
+	unsigned long long nodes;	//0 for no limit
+	Time_Manager* time;		//NULL for no clock, started by the caller
+	int multipv;			//root lines to report, 0 or 1 for the best only
+} Search_Limits;
+
+//one root move and the line that follows it
+typedef struct Search_Line
+{
+	int score;
+	Move pv[MAX_PLY];
+	int pv_length;
+} Search_Line;
+
+typedef struct Search_Result
+{
+	Move best;
+	int score;			//side to move, centipawns or mate
+	int depth;			//deepest completed iteration
+	unsigned long long nodes;
+	Move pv[MAX_PLY];
+	int pv_length;
+	Search_Line lines[MAX_MULTIPV];	//best first, lines[0] matches best / pv
+	int num_lines;
+} Search_Result;
+
+//one ply's move list, ordering scores and undo record
+typedef struct Search_Frame
+{
+	Move moves[MAX_MOVES];
+	int scores[MAX_MOVES];
+	Undo undo;
+} Search_Frame;
+
+//everything one searching thread owns, the table may be shared
+typedef struct Search_Context
+{
+	Transposition_Table* tt;
+	unsigned long long nodes;
+	unsigned long long node_limit;
+	Time_Manager* time;
+	unsigned long long next_check;	//node count of the next clock read
+	int stopped;
+	unsigned short excluded[MAX_MULTIPV];	//move_pack() of root moves already reported
+	int num_excluded;
+	int root_stalemate;		//the iteration's first line found the root stalemated
+
+	Move pv[MAX_PLY][MAX_PLY];
+	int pv_length[MAX_PLY];
+
+	Search_Frame* frames;		//MAX_PLY of them, the search stack
+	Arena* arena;			//what the context is carved from
+	short owns_arena;
+} Search_Context;
+
+Search_Context* search_create(Transposition_Table* tt);
+Search_Context* search_create_in(Arena* arena, Transposition_Table* tt);
+void search_destroy(Search_Context* ctx);
+int search_position(Search_Context* ctx, Position* pos, const Search_Limits* limits,
+		Search_Result* result);
+
+#ifdef SEARCH_IMPLEMENTATION_
+
+#define SCORE_TT_MOVE 1000000
+#define SCORE_CAPTURE 100000
+
+/*********************************************************************
+* Search_Context* search_create_in(Arena* arena, Transposition_Table* tt)
+*
+* 	PURPOSE ::
+*  		carve the per-thread search state and its stack of
+*  		frames from <arena>
+*  			-the context lives until <arena> is reset,
+*  			search_destroy() leaves it alone
+*
+* 	@param
+*	 - arena :: arena to carve from, e.g. arena_thread()
+*	 - tt    :: table to probe and fill, NULL to search without one
+*
+*	 @return
+*	 - NULL :: the arena could not grow
+*	 - ctx  :: newly created context
+*********************************************************************/
+Search_Context* search_create_in(Arena* arena, Transposition_Table* tt)
+{
+	Search_Context* ctx = (Search_Context*)arena_alloc_zero(arena, sizeof(Search_Context));
+	if(!ctx)
+		return NULL;
+	ctx->frames = (Search_Frame*)arena_alloc(arena, MAX_PLY * sizeof(Search_Frame));
+	if(!ctx->frames)
+		return NULL;
+	ctx->tt = tt;
+	ctx->arena = arena;
+	return ctx;
+}
+/*********************************************************************
+* Search_Context* search_create(Transposition_Table* tt)
+*
+* 	PURPOSE ::
+*  		allocate the per-thread search state in an arena of
+*  		its own, freed by search_destroy()
+*
+* 	@param
+*	 - tt :: table to probe and fill, NULL to search without one
+*
+*	 @return
+*	 - NULL :: no memory
+*	 - ctx  :: newly created context
+*********************************************************************/
+Search_Context* search_create(Transposition_Table* tt)
+{
+	Arena* arena = arena_create(sizeof(Search_Context) + MAX_PLY * sizeof(Search_Frame) + 2 * ARENA_ALIGN);
+	if(!arena)
+		return NULL;
+	Search_Context* ctx = search_create_in(arena, tt);
+	if(!ctx)
+	{
+		arena_destroy(arena);
+		return NULL;
+	}
+	ctx->owns_arena = TRUE;
+	return ctx;
+}
+/*********************************************************************
+* void search_destroy(Search_Context* ctx)
+*
+* 	PURPOSE ::
+*  		free a context from search_create(), the table it
+*  		points at is left alone
+*  			-contexts from search_create_in() go with their
+*  			arena, this does nothing to them
+*
+* 	@param
+*	 - ctx :: context to free
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void search_destroy(Search_Context* ctx)
+{
+	if(ctx && ctx->owns_arena)
+		arena_destroy(ctx->arena);
+	return;
+}
+/*********************************************************************
+* static void search_order(const Position* pos, const Move* moves,
+*		int* scores, size_t count, unsigned short tt_move)
+*
+* 	PURPOSE ::
+*  		give each move an ordering score : the table's move,
+*  		then captures by most valuable victim / least
+*  		valuable attacker, then the rest
+*********************************************************************/
+static void search_order(const Position* pos, const Move* moves, int* scores,
+		size_t count, unsigned short tt_move)
+{
+	for(size_t i = 0; i < count; ++i)
+	{
+		const Move* m = &moves[i];
+		char victim = pos->squares[m->dest[0]][m->dest[1]];
+		char attacker = pos->squares[m->origin[0]][m->origin[1]];
+
+		if(tt_move && move_pack(*m) == tt_move)
+			scores[i] = SCORE_TT_MOVE;
+		else if(victim != '.')
+			scores[i] = SCORE_CAPTURE + 10 * (tolower(victim) == 'k' ? MATE_SCORE
+					: eval_params.material[piece_kind(victim)])
+				- eval_params.material[piece_kind(attacker)];
+		else
+			scores[i] = 0;
+	}
+	return;
+}
+/*********************************************************************
+* static void search_pick(Move* moves, int* scores, size_t from,
+*		size_t count)
+*
+* 	PURPOSE ::
+*  		swap the best scored move left in <moves> into <from>,
+*  		cheaper than sorting when a cutoff comes early
+*********************************************************************/
+static void search_pick(Move* moves, int* scores, size_t from, size_t count)
+{
+	size_t best = from;
+	for(size_t i = from + 1; i < count; ++i)
+		if(scores[i] > scores[best])
+			best = i;
+	if(best == from)
+		return;
+
+	Move move = moves[from];
+	moves[from] = moves[best];
+	moves[best] = move;
+	int score = scores[from];
+	scores[from] = scores[best];
+	scores[best] = score;
+	return;
+}
+/*********************************************************************
+* static int search_out_of_nodes(Search_Context* ctx)
+*
+* 	PURPOSE ::
+*  		count a node and stop the search once the budget is spent
+*  			-the clock is read only every check_nodes nodes
+*********************************************************************/
+static int search_out_of_nodes(Search_Context* ctx)
+{
+	ctx->nodes++;
+	if(ctx->node_limit && ctx->nodes >= ctx->node_limit)
+		ctx->stopped = TRUE;
+	if(ctx->time && ctx->nodes >= ctx->next_check)
+	{
+		ctx->next_check = ctx->nodes + ctx->time->check_nodes;
+		if(time_manager_hard_expired(ctx->time))
+			ctx->stopped = TRUE;
+	}
+	return ctx->stopped;
+}
+/*********************************************************************
+* static int search_excluded(const Search_Context* ctx, Move move)
+*
+* 	PURPOSE ::
+*  		is <move> a root move an earlier line already took
+*********************************************************************/
+static int search_excluded(const Search_Context* ctx, Move move)
+{
+	unsigned short packed = move_pack(move);
+	for(int i = 0; i < ctx->num_excluded; ++i)
+		if(ctx->excluded[i] == packed)
+			return TRUE;
+	return FALSE;
+}
+/*********************************************************************
+* static int search_quiesce(Search_Context* ctx, Position* pos,
+*		int alpha, int beta, int ply)
+*
+* 	PURPOSE ::
+*  		follow captures until the position is quiet, so the
+*  		evaluation is never taken in the middle of a trade
+*********************************************************************/
+static int search_quiesce(Search_Context* ctx, Position* pos, int alpha, int beta, int ply)
+{
+	if(search_out_of_nodes(ctx))
+		return 0;
+	STAT_INC(STAT_QNODES);
+
+	int stand = evaluate(pos);
+	if(stand >= beta || ply >= MAX_PLY - 1)
+		return stand;
+	if(stand > alpha)
+		alpha = stand;
+
+	Search_Frame* frame = &ctx->frames[ply];
+	Move* moves = frame->moves;
+	int* scores = frame->scores;
+	Move_Set set;
+	generate_moves(pos, &set);
+	size_t count = move_set_to_list(&set, moves);
+
+	//keep only the captures
+	size_t captures = 0;
+	for(size_t i = 0; i < count; ++i)
+		if(pos->squares[moves[i].dest[0]][moves[i].dest[1]] != '.')
+			moves[captures++] = moves[i];
+	search_order(pos, moves, scores, captures, 0);
+
+	for(size_t i = 0; i < captures; ++i)
+	{
+		search_pick(moves, scores, i, captures);
+
+		int score;
+		if(tolower(position_make_move_undo(pos, moves[i], &frame->undo)) == 'k')
+			score = MATE_SCORE - (ply + 1);
+		else
+			score = -search_quiesce(ctx, pos, -beta, -alpha, ply + 1);
+		position_unmake_move(pos, &frame->undo);
+
+		if(ctx->stopped)
+			return 0;
+		if(score >= beta)
+			return score;
+		if(score > alpha)
+			alpha = score;
+	}
+	return alpha;
+}
+/*********************************************************************
+* static int search_alpha_beta(Search_Context* ctx, Position* pos,
+*		int depth, int alpha, int beta, int ply)
+*
+* 	PURPOSE ::
+*  		negamax alpha-beta to <depth>
+*  			-taking the king ends the game, so a capture of
+*  			it scores as mate without searching further
+*  			-a side with no moves, or fifty moves without
+*  			progress, scores as a draw
+*  			-a side whose every move loses the king is mated
+*  			only when its king is attacked already, otherwise
+*  			it is stalemated and scores as a draw
+*  			-root moves in ctx->excluded are skipped, and
+*  			such a root is not stored, its score is not the
+*  			position's
+*********************************************************************/
+static int search_alpha_beta(Search_Context* ctx, Position* pos, int depth,
+		int alpha, int beta, int ply)
+{
+	ctx->pv_length[ply] = 0;
+	if(depth <= 0 || ply >= MAX_PLY - 1)
+		return search_quiesce(ctx, pos, alpha, beta, ply);
+	if(search_out_of_nodes(ctx))
+		return 0;
+	STAT_INC(STAT_NODES);
+	if(ply > 0 && pos->halfmove >= FIFTY_MOVE_PLIES)
+		return 0;
+
+	const int alpha_in = alpha;
+	unsigned long long key = position_hash(pos);
+	unsigned short tt_move = 0;
+	Tt_Hit hit;
+	if(ctx->tt && tt_probe(ctx->tt, key, &hit))
+	{
+		tt_move = hit.move;
+		//mate scores are stored relative to the node, not the root
+		int score = hit.score;
+		if(score > MATE_BOUND)
+			score -= ply;
+		else if(score < -MATE_BOUND)
+			score += ply;
+
+		if(ply > 0 && hit.depth >= depth &&
+		   (hit.bound == TT_EXACT ||
+		   (hit.bound == TT_LOWER && score >= beta) ||
+		   (hit.bound == TT_UPPER && score <= alpha)))
+			return score;
+	}
+
+	Search_Frame* frame = &ctx->frames[ply];
+	Move* moves = frame->moves;
+	int* scores = frame->scores;
+	Move_Set set;
+	generate_moves(pos, &set);
+	size_t count = move_set_to_list(&set, moves);
+	if(count == 0)
+		return 0;
+	search_order(pos, moves, scores, count, tt_move);
+
+	int best_score = -INFINITE_SCORE;
+	unsigned short best_move = 0;
+	for(size_t i = 0; i < count; ++i)
+	{
+		search_pick(moves, scores, i, count);
+		if(ply == 0 && ctx->num_excluded > 0 && search_excluded(ctx, moves[i]))
+			continue;
+
+		int score;
+		if(tolower(position_make_move_undo(pos, moves[i], &frame->undo)) == 'k')
+		{
+			score = MATE_SCORE - (ply + 1);
+			ctx->pv_length[ply + 1] = 0;
+		}
+		else
+			score = -search_alpha_beta(ctx, pos, depth - 1, -beta, -alpha, ply + 1);
+		position_unmake_move(pos, &frame->undo);
+
+		if(ctx->stopped)
+			return 0;
+		if(score <= best_score)
+			continue;
+
+		best_score = score;
+		best_move = move_pack(moves[i]);
+		if(score > alpha)
+		{
+			alpha = score;
+			ctx->pv[ply][0] = moves[i];
+			memcpy(&ctx->pv[ply][1], ctx->pv[ply + 1],
+					(size_t)ctx->pv_length[ply + 1] * sizeof(Move));
+			ctx->pv_length[ply] = ctx->pv_length[ply + 1] + 1;
+		}
+		if(alpha >= beta)
+		{
+			STAT_INC(STAT_CUTOFFS);
+			if(i == 0)
+				STAT_INC(STAT_FIRST_MOVE_CUTOFFS);
+			break;
+		}
+	}
+
+	//every move searched hands the king over. Root moves left out
+	//by earlier lines were not searched, the first line decides
+	if(best_score == -(MATE_SCORE - (ply + 2)) && best_score < beta)
+	{
+		int stalemate = (ply == 0 && ctx->num_excluded > 0) ? ctx->root_stalemate
+			: !position_in_check(pos);
+		if(ply == 0 && ctx->num_excluded == 0)
+			ctx->root_stalemate = stalemate;
+		if(stalemate)
+			best_score = 0;
+	}
+
+	if(ctx->tt && !(ply == 0 && ctx->num_excluded > 0))
+	{
+		Tt_Bound bound = (best_score >= beta) ? TT_LOWER
+			: (best_score > alpha_in) ? TT_EXACT : TT_UPPER;
+		int stored = best_score;
+		if(stored > MATE_BOUND)
+			stored += ply;
+		else if(stored < -MATE_BOUND)
+			stored -= ply;
+		tt_store(ctx->tt, key, best_move, (short)stored, (signed char)depth, bound);
+	}
+	return best_score;
+}
+/*********************************************************************
+* static void search_save_line(Search_Line* lines, int* count,
+*		const Search_Context* ctx, int score)
+*
+* 	PURPOSE ::
+*  		add the root line just searched to <lines>, kept best
+*  		first
+*  			-a later line can come back above an earlier
+*  			one when the table has moved on in between, so
+*  			it is inserted rather than appended
+*********************************************************************/
+static void search_save_line(Search_Line* lines, int* count, const Search_Context* ctx, int score)
+{
+	int at = *count;
+	while(at > 0 && lines[at - 1].score < score)
+	{
+		lines[at] = lines[at - 1];
+		at--;
+	}
+	lines[at].score = score;
+	lines[at].pv_length = ctx->pv_length[0];
+	memcpy(lines[at].pv, ctx->pv[0], (size_t)ctx->pv_length[0] * sizeof(Move));
+	(*count)++;
+	return;
+}
+/*********************************************************************
+* int search_position(Search_Context* ctx, Position* pos,
+*		const Search_Limits* limits, Search_Result* result)
+*
+* 	PURPOSE ::
+*  		iteratively deepen on <pos> until <limits> run out
+*  			-<pos> is searched in place and restored before
+*  			returning
+*  			-the result is the last completed iteration, an
+*  			iteration cut short by the node budget or the
+*  			hard time limit is dropped (except the first, so
+*  			there is always a move)
+*  			-with a time manager, each completed iteration
+*  			asks it whether to go deeper
+*  			-with limits->multipv above 1, each iteration
+*  			searches the root again with the moves already
+*  			found left out, until that many lines are in.
+*  			The table is kept across them, so every line
+*  			after the first mostly replays stored work
+*
+* 	@param
+*	 - ctx    :: from search_create()
+*	 - pos    :: the position to search
+*	 - limits :: depth, node budget, time manager and / or
+*	 	     line count
+*	 - result :: receives best move, score and line, and the
+*	 	     other lines best first
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: the side to move has no moves
+*********************************************************************/
+int search_position(Search_Context* ctx, Position* pos, const Search_Limits* limits,
+		Search_Result* result)
+{
+	if(!ctx || !pos || !result)
+	{
+		error_noexist("ctx", "search_position");
+		return FAILURE;
+	}
+
+	memset(result, 0, sizeof(*result));
+	ctx->nodes = 0;
+	ctx->node_limit = limits ? limits->nodes : 0;
+	ctx->time = limits ? limits->time : NULL;
+	ctx->next_check = ctx->time ? ctx->time->check_nodes : 0;
+	ctx->stopped = FALSE;
+	if(ctx->tt)
+		tt_new_search(ctx->tt);
+
+	Move_Set set;
+	generate_moves(pos, &set);
+	int root_moves = (int)move_set_count(&set);
+	if(root_moves == 0)
+		return FAILURE;
+	Move first[MAX_MOVES];
+	move_set_to_list(&set, first);
+	result->best = first[0];
+
+	int max_lines = (limits && limits->multipv > 1) ? limits->multipv : 1;
+	if(max_lines > MAX_MULTIPV)
+		max_lines = MAX_MULTIPV;
+	if(max_lines > root_moves)
+		max_lines = root_moves;
+
+	Search_Line lines[MAX_MULTIPV];
+	int max_depth = (limits && limits->depth > 0 && limits->depth < MAX_PLY) ? limits->depth : MAX_PLY - 1;
+	for(int depth = 1; depth <= max_depth; ++depth)
+	{
+		int found = 0;
+		int score = 0;
+		ctx->num_excluded = 0;
+		ctx->root_stalemate = FALSE;
+		while(found < max_lines)
+		{
+			score = search_alpha_beta(ctx, pos, depth, -INFINITE_SCORE, INFINITE_SCORE, 0);
+			if((ctx->stopped && depth > 1) || ctx->pv_length[0] == 0)
+				break;
+			search_save_line(lines, &found, ctx, score);
+			ctx->excluded[ctx->num_excluded++] = move_pack(ctx->pv[0][0]);
+			if(ctx->stopped)
+				break;
+		}
+		ctx->num_excluded = 0;
+		if(ctx->stopped && depth > 1)
+			break;
+
+		if(found > 0)
+		{
+			memcpy(result->lines, lines, (size_t)found * sizeof(Search_Line));
+			result->num_lines = found;
+			result->best = lines[0].pv[0];
+			result->pv_length = lines[0].pv_length;
+			memcpy(result->pv, lines[0].pv, (size_t)lines[0].pv_length * sizeof(Move));
+			score = lines[0].score;
+		}
+		result->score = score;
+		result->depth = depth;
+		if(ctx->stopped || score > MATE_BOUND || score < -MATE_BOUND)
+			break;
+		if(ctx->time && time_manager_iteration_done(ctx->time, move_pack(result->best), score))
+			break;
+	}
+
+	result->nodes = ctx->nodes;
+	return 0;
+}
+#endif //SEARCH_IMPLEMENTATION_
+#endif //SEARCH_H_
@@ -0,0 +1,633 @@
+#ifndef SELF_PLAY_H_
+#define SELF_PLAY_H_
+
+///user defined
+#include "position.h"
+#include "position_pack.h"
+#include "move_gen.h"
+#include "zobrist.h"
+#include "search.h"
+#include "tt.h"
+#include "ring_queue.h"
+#include "stats.h"
+#include "arena.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+//longest game kept, anything longer is adjudicated a draw
+#define MAX_GAME_PLIES 512
+//finished games waiting for the writer
+#define WRITER_QUEUE_SIZE 1024
+//openings tried at one length before settling for a ply shorter
+#define OPENING_TRIES 16
+
+//one training position, the output file is a plain array of these
+typedef struct Self_Play_Record
+{
+	Packed_Position position;
+	short score;			//search score, side to move
+	signed char result;		//1 white won, 0 draw, -1 black won
+	unsigned char flags;
+	unsigned short ply;
+	unsigned short padding;
+} Self_Play_Record;
+
+typedef struct Self_Play_Config
+{
+	size_t num_threads;		//0 for one per core
+	size_t games;			//total games to play
+	size_t games_per_thread;	//games each thread keeps in flight
+	unsigned long long nodes;	//node budget per move
+	int random_plies;		//random opening moves, not recorded
+	int max_plies;			//draw after this many, <= MAX_GAME_PLIES
+	size_t tt_bytes;		//table size per thread
+	unsigned long long seed;
+	const char* output_path;
+} Self_Play_Config;
+
+typedef struct Self_Play_Stats
+{
+	unsigned long long games;
+	unsigned long long positions;
+	unsigned long long white_wins;
+	unsigned long long black_wins;
+	unsigned long long draws;
+	double seconds;
+	double games_per_hour;
+	double positions_per_second;
+} Self_Play_Stats;
+
+void self_play_defaults(Self_Play_Config* config);
+Game_Status self_play_adjudicate(const Position* pos, const unsigned long long* history,
+		size_t plies, int max_plies);
+short self_play_run(const Self_Play_Config* config, Self_Play_Stats* stats);
+void self_play_print_stats(const Self_Play_Stats* stats);
+
+#ifdef SELF_PLAY_IMPLEMENTATION_
+
+_Static_assert(sizeof(Self_Play_Record) == 40, "Self_Play_Record must stay 40 bytes");
+
+//a finished game on its way to the writer
+typedef struct Record_Batch
+{
+	Self_Play_Record* records;
+	size_t count;
+} Record_Batch;
+
+//one game a worker is juggling
+typedef struct Game_Slot
+{
+	Position pos;
+	unsigned long long history[MAX_GAME_PLIES + 1];
+	Self_Play_Record* records;
+	size_t count;
+	size_t plies;
+	unsigned long long rng;
+	short active;
+} Game_Slot;
+
+//state shared by every worker and the writer
+typedef struct Self_Play_Shared
+{
+	const Self_Play_Config* config;
+	Ring_Queue queue;
+	FILE* output;
+
+	atomic_size_t games_started;
+	atomic_size_t workers_left;
+	atomic_ullong games;
+	atomic_ullong positions;
+	atomic_ullong white_wins;
+	atomic_ullong black_wins;
+	atomic_ullong draws;
+} Self_Play_Shared;
+
+/*********************************************************************
+* void self_play_defaults(Self_Play_Config* config)
+*
+* 	PURPOSE ::
+*  		fill <config> with settings that suit bulk data runs
+*
+* 	@param
+*	 - config :: overwritten
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void self_play_defaults(Self_Play_Config* config)
+{
+	memset(config, 0, sizeof(*config));
+	config->num_threads = 0;
+	config->games = 1000;
+	config->games_per_thread = 64;
+	config->nodes = 2000;
+	config->random_plies = 8;
+	config->max_plies = 300;
+	config->tt_bytes = 1 << 20;
+	config->seed = 1;
+	config->output_path = "selfplay.bin";
+	return;
+}
+/*********************************************************************
+* static unsigned long long self_play_random(unsigned long long* state)
+*
+* 	PURPOSE ::
+*  		xorshift64*, one stream per game so runs repeat exactly
+*********************************************************************/
+static unsigned long long self_play_random(unsigned long long* state)
+{
+	unsigned long long x = *state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return x * 0x2545F4914F6CDD1DULL;
+}
+/*********************************************************************
+* static int self_play_bare_kings(const Position* pos)
+*
+* 	PURPOSE ::
+*  		nothing but kings, and at most one minor piece, left :
+*  		no one can ever take a king
+*********************************************************************/
+static int self_play_bare_kings(const Position* pos)
+{
+	size_t minors = 0;
+	for(size_t row = 0; row < NUM_ROWS; ++row)
+		for(size_t col = 0; col < NUM_COLS; ++col)
+		{
+			char piece = tolower(pos->squares[row][col]);
+			if(piece == '.' || piece == 'k')
+				continue;
+			if(piece != 'n' && piece != 'b')
+				return FALSE;
+			minors++;
+		}
+	return minors <= 1;
+}
+/*********************************************************************
+* static int self_play_stalemate(const Position* pos, const Move_Set* set)
+*
+* 	PURPOSE ::
+*  		is the side to move out of check with every move in
+*  		<set> handing the other side its king
+*  			-moves are pseudo-legal, left alone the game
+*  			would end a ply later on a king capture
+*  			-stops at the first move that keeps the king,
+*  			which is nearly always the first one tried
+*********************************************************************/
+static int self_play_stalemate(const Position* pos, const Move_Set* set)
+{
+	if(position_in_check(pos))
+		return FALSE;
+
+	Move moves[MAX_MOVES];
+	size_t count = move_set_to_list(set, moves);
+	for(size_t i = 0; i < count; ++i)
+	{
+		Position after = *pos;
+		position_make_move(&after, moves[i]);
+		//ask about the mover's king, not the one now to move
+		after.side = pos->side;
+		if(!position_in_check(&after))
+			return FALSE;
+	}
+	return TRUE;
+}
+/*********************************************************************
+* Game_Status self_play_adjudicate(const Position* pos,
+*		const unsigned long long* history, size_t plies,
+*		int max_plies)
+*
+* 	PURPOSE ::
+*  		decide whether a game is over : position_status(), plus
+*  		the draws that need the game so far
+*  			-third repetition of a position
+*  			-side to move has no moves, or is stalemated :
+*  			not in check with every move losing its king
+*  			-bare kings
+*  			-<max_plies> reached
+*
+* 	@param
+*	 - pos       :: current position
+*	 - history   :: position_hash() of every position so far,
+*	 	        <pos> last
+*	 - plies     :: moves played, history has plies + 1 entries
+*	 - max_plies :: game length cap
+*
+*	 @return
+*	 - Game_Status :: GAME_ONGOING, or who won / GAME_DRAW
+*********************************************************************/
+Game_Status self_play_adjudicate(const Position* pos, const unsigned long long* history,
+		size_t plies, int max_plies)
+{
+	Game_Status status = position_status(pos);
+	if(status != GAME_ONGOING)
+		return status;
+	if(plies >= (size_t)max_plies)
+		return GAME_DRAW;
+	if(self_play_bare_kings(pos))
+		return GAME_DRAW;
+
+	//repetitions can only reach back to the last capture or pawn move
+	size_t seen = 0;
+	size_t reach = (pos->halfmove < plies) ? pos->halfmove : plies;
+	for(size_t back = 2; back <= reach; back += 2)
+		if(history[plies - back] == history[plies] && ++seen >= 2)
+			return GAME_DRAW;
+
+	Move_Set set;
+	generate_moves(pos, &set);
+	if(move_set_count(&set) == 0 || self_play_stalemate(pos, &set))
+		return GAME_DRAW;
+	return GAME_ONGOING;
+}
+/*********************************************************************
+* static short self_play_start(Self_Play_Shared* shared, Game_Slot* slot)
+*
+* 	PURPOSE ::
+*  		claim the next game and play its random opening
+*  			-FALSE once every game has been handed out
+*  			-an opening that ends the game is replayed, after
+*  			OPENING_TRIES misses the opening gets a ply
+*  			shorter, so an empty opening always ends it
+*********************************************************************/
+static short self_play_start(Self_Play_Shared* shared, Game_Slot* slot)
+{
+	const Self_Play_Config* config = shared->config;
+	size_t game = atomic_fetch_add(&shared->games_started, 1);
+	if(game >= config->games)
+		return FALSE;
+
+	slot->rng = (config->seed ^ (game * 0x9E3779B97F4A7C15ULL)) | 1;
+	slot->count = 0;
+	slot->active = TRUE;
+
+	//retry openings that end the game before it starts
+	int random_plies = config->random_plies;
+	for(int tries = 1; ; ++tries)
+	{
+		position_init(&slot->pos);
+		slot->plies = 0;
+		slot->history[0] = position_hash(&slot->pos);
+
+		int ply = 0;
+		for(; ply < random_plies; ++ply)
+		{
+			Move_Set set;
+			Move moves[MAX_MOVES];
+			generate_moves(&slot->pos, &set);
+			size_t count = move_set_to_list(&set, moves);
+			if(count == 0)
+				break;
+			position_make_move(&slot->pos, moves[self_play_random(&slot->rng) % count]);
+			slot->history[++slot->plies] = position_hash(&slot->pos);
+			if(self_play_adjudicate(&slot->pos, slot->history, slot->plies,
+						config->max_plies) != GAME_ONGOING)
+				break;
+		}
+		if(ply == random_plies)
+			return TRUE;
+		if(tries % OPENING_TRIES == 0)
+			random_plies--;
+	}
+}
+/*********************************************************************
+* static void self_play_finish(Self_Play_Shared* shared, Game_Slot* slot,
+*		Game_Status status)
+*
+* 	PURPOSE ::
+*  		stamp the result on every recorded position and hand
+*  		the game to the writer
+*********************************************************************/
+static void self_play_finish(Self_Play_Shared* shared, Game_Slot* slot, Game_Status status)
+{
+	signed char result = 0;
+	if(status == GAME_WHITE_WINS)
+	{
+		result = 1;
+		atomic_fetch_add(&shared->white_wins, 1);
+	}
+	else if(status == GAME_BLACK_WINS)
+	{
+		result = -1;
+		atomic_fetch_add(&shared->black_wins, 1);
+	}
+	else
+		atomic_fetch_add(&shared->draws, 1);
+
+	Record_Batch batch = { NULL, slot->count };
+	if(slot->count)
+	{
+		batch.records = (Self_Play_Record*)malloc(slot->count * sizeof(Self_Play_Record));
+		if(!batch.records)
+			error_nomem();
+		for(size_t i = 0; i < slot->count; ++i)
+		{
+			batch.records[i] = slot->records[i];
+			batch.records[i].result = result;
+		}
+		while(ring_queue_push(&shared->queue, &batch) != TRUE)
+			sched_yield();
+	}
+
+	atomic_fetch_add(&shared->games, 1);
+	atomic_fetch_add(&shared->positions, slot->count);
+	slot->active = FALSE;
+	return;
+}
+/*********************************************************************
+* static void self_play_step(Self_Play_Shared* shared, Search_Context* ctx,
+*		Game_Slot* slot)
+*
+* 	PURPOSE ::
+*  		play one move of one game : adjudicate, search, record,
+*  		move on
+*  			-a search that sees a forced king capture ends
+*  			the game right there
+*********************************************************************/
+static void self_play_step(Self_Play_Shared* shared, Search_Context* ctx, Game_Slot* slot)
+{
+	const Self_Play_Config* config = shared->config;
+	Game_Status status = self_play_adjudicate(&slot->pos, slot->history, slot->plies,
+			config->max_plies);
+	if(status != GAME_ONGOING)
+	{
+		self_play_finish(shared, slot, status);
+		return;
+	}
+
+	Search_Limits limits = { .nodes = config->nodes };
+	Search_Result result;
+	if(search_position(ctx, &slot->pos, &limits, &result) != 0)
+	{
+		self_play_finish(shared, slot, GAME_DRAW);
+		return;
+	}
+
+	Self_Play_Record* record = &slot->records[slot->count];
+	memset(record, 0, sizeof(*record));
+	if(position_pack(&slot->pos, &record->position) == 0)
+	{
+		record->score = (short)result.score;
+		record->ply = (unsigned short)slot->plies;
+		slot->count++;
+	}
+
+	if(result.score > MATE_BOUND || result.score < -MATE_BOUND)
+	{
+		short mover_wins = (result.score > 0);
+		short white_moves = (slot->pos.side == WHITE);
+		self_play_finish(shared, slot, (mover_wins == white_moves) ? GAME_WHITE_WINS : GAME_BLACK_WINS);
+		return;
+	}
+
+	position_make_move(&slot->pos, result.best);
+	slot->history[++slot->plies] = position_hash(&slot->pos);
+	return;
+}
+/*********************************************************************
+* static void self_play_games(Self_Play_Shared* shared, Arena* arena)
+*
+* 	PURPOSE ::
+*  		keep games_per_thread games going, one move at a time
+*  		round robin, until no games are left to start
+*  			-slots, record buffers and the search stack are
+*  			carved from <arena> once and reused by every
+*  			game the slot plays
+*  			-leaves the calling thread's own state alone,
+*  			so self_play_run() can call it inline
+*********************************************************************/
+static void self_play_games(Self_Play_Shared* shared, Arena* arena)
+{
+	const Self_Play_Config* config = shared->config;
+	Transposition_Table* tt = tt_create(config->tt_bytes);
+	Search_Context* ctx = search_create_in(arena, tt);
+	Game_Slot* slots = (Game_Slot*)arena_alloc_zero(arena, config->games_per_thread * sizeof(Game_Slot));
+	if(!tt || !ctx || !slots)
+		error_nomem();
+	for(size_t i = 0; i < config->games_per_thread; ++i)
+	{
+		slots[i].records = (Self_Play_Record*)arena_alloc(arena, MAX_GAME_PLIES * sizeof(Self_Play_Record));
+		if(!slots[i].records)
+			error_nomem();
+	}
+
+	short more_games = TRUE;
+	size_t active = 0;
+	do
+	{
+		active = 0;
+		for(size_t i = 0; i < config->games_per_thread; ++i)
+		{
+			Game_Slot* slot = &slots[i];
+			if(!slot->active && more_games)
+				more_games = self_play_start(shared, slot);
+			if(!slot->active)
+				continue;
+			self_play_step(shared, ctx, slot);
+			active++;
+		}
+	} while(active > 0 || more_games);
+
+	tt_destroy(tt);
+	atomic_fetch_sub(&shared->workers_left, 1);
+	return;
+}
+/*********************************************************************
+* static void* self_play_worker(void* arg)
+*
+* 	PURPOSE ::
+*  		thread entry : self_play_games() on this thread's
+*  		arena, with its counters registered for stats
+*********************************************************************/
+static void* self_play_worker(void* arg)
+{
+	stats_register_thread();
+	self_play_games((Self_Play_Shared*)arg, arena_thread());
+	arena_thread_release();
+	stats_unregister_thread();
+	return NULL;
+}
+/*********************************************************************
+* static void* self_play_writer(void* arg)
+*
+* 	PURPOSE ::
+*  		drain finished games into the output file until every
+*  		worker is done and the queue is empty
+*********************************************************************/
+static void* self_play_writer(void* arg)
+{
+	Self_Play_Shared* shared = (Self_Play_Shared*)arg;
+	Record_Batch batch;
+
+	for(;;)
+	{
+		if(ring_queue_pop(&shared->queue, &batch) == TRUE)
+		{
+			if(fwrite(batch.records, sizeof(Self_Play_Record), batch.count, shared->output) != batch.count)
+				perror("Could not write self-play records\n\t{self_play_writer}\n");
+			free(batch.records);
+			continue;
+		}
+		if(atomic_load(&shared->workers_left) == 0)
+		{
+			//a last batch may have landed after the pop above
+			if(ring_queue_pop(&shared->queue, &batch) != TRUE)
+				break;
+			if(fwrite(batch.records, sizeof(Self_Play_Record), batch.count, shared->output) != batch.count)
+				perror("Could not write self-play records\n\t{self_play_writer}\n");
+			free(batch.records);
+			continue;
+		}
+		struct timespec nap = { 0, 100000 };
+		nanosleep(&nap, NULL);
+	}
+	return NULL;
+}
+/*********************************************************************
+* short self_play_run(const Self_Play_Config* config,
+*		Self_Play_Stats* stats)
+*
+* 	PURPOSE ::
+*  		play config->games games of the engine against itself
+*  		on every core and stream the positions to
+*  		config->output_path
+*  			-each thread juggles many games, each with its
+*  			own position and history, sharing one table
+*  			per thread
+*  			-a single writer thread owns the file, workers
+*  			hand it finished games through a lock-free queue
+*
+* 	@param
+*	 - config :: see self_play_defaults()
+*	 - stats  :: receives totals and rates, may be NULL
+*
+*	 @return
+*	 - 0       :: success
+*	 - FAILURE :: bad config or the output could not be opened
+*********************************************************************/
+short self_play_run(const Self_Play_Config* config, Self_Play_Stats* stats)
+{
+	if(!config || !config->output_path || config->games_per_thread == 0 ||
+	   config->max_plies < 1 || config->max_plies > MAX_GAME_PLIES ||
+	   config->random_plies < 0 || config->random_plies >= config->max_plies)
+	{
+		fprintf(stderr, "Bad self-play configuration\n");
+		return FAILURE;
+	}
+
+	size_t num_threads = config->num_threads;
+	if(num_threads == 0)
+	{
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		num_threads = (cores > 0) ? (size_t)cores : 1;
+	}
+
+	Self_Play_Shared* shared = (Self_Play_Shared*)aligned_alloc(CACHE_LINE,
+			(sizeof(Self_Play_Shared) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE);
+	if(!shared)
+		error_nomem();
+	memset(shared, 0, sizeof(*shared));
+	shared->config = config;
+	shared->output = fopen(config->output_path, "wb");
+	if(!shared->output)
+	{
+		perror("Could not open self-play output\n\t{self_play_run}\n");
+		free(shared);
+		return FAILURE;
+	}
+	if(ring_queue_init(&shared->queue, WRITER_QUEUE_SIZE, sizeof(Record_Batch)) != 0)
+		error_nomem();
+	atomic_init(&shared->games_started, 0);
+	atomic_init(&shared->workers_left, num_threads);
+
+	zobrist_init();
+	unsigned long long start = time_now_ns();
+
+	pthread_t writer;
+	pthread_t* workers = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+	if(!workers)
+		error_nomem();
+	if(pthread_create(&writer, NULL, self_play_writer, shared) != 0)
+	{
+		perror("Could not start the self-play writer\n\t{self_play_run}\n");
+		fclose(shared->output);
+		ring_queue_free(&shared->queue);
+		free(workers);
+		free(shared);
+		return FAILURE;
+	}
+	size_t started = 0;
+	for(size_t i = 0; i < num_threads; ++i)
+		if(pthread_create(&workers[started], NULL, self_play_worker, shared) == 0)
+			started++;
+	//the workers that did start play the missing ones' share, with
+	//none at all the games are played here, on an arena of their
+	//own so the caller's is left alone. Only workers that exist
+	//may count towards the writer's exit
+	if(started == 0)
+	{
+		atomic_fetch_sub(&shared->workers_left, num_threads - 1);
+		Arena* arena = arena_create(ARENA_DEFAULT_BLOCK);
+		if(!arena)
+			error_nomem();
+		self_play_games(shared, arena);
+		arena_destroy(arena);
+	}
+	else
+		atomic_fetch_sub(&shared->workers_left, num_threads - started);
+	for(size_t i = 0; i < started; ++i)
+		pthread_join(workers[i], NULL);
+	pthread_join(writer, NULL);
+
+	double seconds = (double)(time_now_ns() - start) / 1e9;
+	fclose(shared->output);
+	ring_queue_free(&shared->queue);
+
+	if(stats)
+	{
+		stats->games      = atomic_load(&shared->games);
+		stats->positions  = atomic_load(&shared->positions);
+		stats->white_wins = atomic_load(&shared->white_wins);
+		stats->black_wins = atomic_load(&shared->black_wins);
+		stats->draws      = atomic_load(&shared->draws);
+		stats->seconds    = seconds;
+		stats->games_per_hour = (seconds > 0.0) ? (double)stats->games / seconds * 3600.0 : 0.0;
+		stats->positions_per_second = (seconds > 0.0) ? (double)stats->positions / seconds : 0.0;
+	}
+
+	free(workers);
+	free(shared);
+	return 0;
+}
+/*********************************************************************
+* void self_play_print_stats(const Self_Play_Stats* stats)
+*
+* 	PURPOSE ::
+*  		print the totals and rates of a self_play_run()
+*
+* 	@param
+*	 - stats :: filled in by self_play_run()
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void self_play_print_stats(const Self_Play_Stats* stats)
+{
+	printf("games      : %llu (+%llu =%llu -%llu) in %.1fs\n", stats->games,
+			stats->white_wins, stats->draws, stats->black_wins, stats->seconds);
+	printf("games/hour : %.0f\n", stats->games_per_hour);
+	printf("positions  : %llu (%.0f/s)\n", stats->positions, stats->positions_per_second);
+	return;
+}
+#endif //SELF_PLAY_IMPLEMENTATION_
+#endif //SELF_PLAY_H_
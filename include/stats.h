@@ -0,0 +1,321 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+///user defined
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+//build with -DENGINE_STATS for the counters, add -DENGINE_STATS_TIMERS
+//for the cycle timers. without them every STAT_ macro is empty and the
+//hot paths compile exactly as if they were never instrumented
+#if defined(ENGINE_STATS_TIMERS) && !defined(ENGINE_STATS)
+#define ENGINE_STATS
+#endif
+
+#define STATS_MAX_THREADS 256
+
+typedef enum Stat_Counter
+{
+	STAT_NODES = 0,
+	STAT_QNODES,
+	STAT_TT_PROBES,
+	STAT_TT_HITS,
+	STAT_CUTOFFS,
+	STAT_FIRST_MOVE_CUTOFFS,
+	STAT_MOVEGEN_CALLS,
+	STAT_EVAL_CALLS,
+	STAT_CACHE_PROBES,
+	STAT_CACHE_HITS,
+	NUM_STAT_COUNTERS
+} Stat_Counter;
+
+typedef enum Stat_Timer
+{
+	TIMER_MOVEGEN = 0,
+	TIMER_MAKE_UNMAKE,
+	TIMER_EVAL,
+	NUM_STAT_TIMERS
+} Stat_Timer;
+
+//one thread's counters, or all of them merged
+typedef struct Engine_Stats
+{
+	unsigned long long counters[NUM_STAT_COUNTERS];
+	unsigned long long timer_calls[NUM_STAT_TIMERS];
+	unsigned long long timer_cycles[NUM_STAT_TIMERS];
+	size_t threads;			//threads merged in
+} Engine_Stats;
+
+//each thread only ever writes its own copy, no atomics, no sharing
+extern _Thread_local Engine_Stats thread_stats;
+
+void stats_register_thread(void);
+void stats_unregister_thread(void);
+void stats_collect(Engine_Stats* merged);
+void stats_reset(void);
+void stats_print(FILE* out, const Engine_Stats* stats);
+void stats_dump_json(FILE* out, const Engine_Stats* stats);
+
+#ifdef ENGINE_STATS
+#define STAT_INC(counter) ((void)thread_stats.counters[counter]++)
+#define STAT_ADD(counter, amount) ((void)(thread_stats.counters[counter] += (amount)))
+#else
+#define STAT_INC(counter) ((void)0)
+#define STAT_ADD(counter, amount) ((void)0)
+#endif
+
+#ifdef ENGINE_STATS_TIMERS
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STATS_CYCLES() __rdtsc()
+#else
+#define STATS_CYCLES() time_now_ns()
+#endif
+
+typedef struct Stats_Scope
+{
+	Stat_Timer timer;
+	unsigned long long start;
+} Stats_Scope;
+
+static inline void stats_scope_end(Stats_Scope* scope)
+{
+	thread_stats.timer_cycles[scope->timer] += STATS_CYCLES() - scope->start;
+	thread_stats.timer_calls[scope->timer]++;
+}
+
+//times from here to the end of the enclosing block, however it is left
+#define STAT_TIMER(timer) \
+	Stats_Scope stats_scope_##timer __attribute__((cleanup(stats_scope_end))) = { timer, STATS_CYCLES() }
+#else
+#define STAT_TIMER(timer) ((void)0)
+#endif
+
+#ifdef STATS_IMPLEMENTATION_
+
+_Thread_local Engine_Stats thread_stats;
+
+static const char* const stat_counter_names[NUM_STAT_COUNTERS] = {
+	"nodes", "qnodes", "tt_probes", "tt_hits", "cutoffs", "first_move_cutoffs",
+	"movegen_calls", "eval_calls", "cache_probes", "cache_hits"
+};
+static const char* const stat_timer_names[NUM_STAT_TIMERS] = {
+	"movegen", "make_unmake", "eval"
+};
+
+//every live thread's counters, plus what finished threads left behind
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static Engine_Stats* stats_threads[STATS_MAX_THREADS];
+static size_t stats_num_threads = 0;
+static Engine_Stats stats_retired;
+
+/*********************************************************************
+* static void stats_add(Engine_Stats* into, const Engine_Stats* from)
+*
+* 	PURPOSE ::
+*  		sum every counter and timer of <from> into <into>
+*********************************************************************/
+static void stats_add(Engine_Stats* into, const Engine_Stats* from)
+{
+	for(size_t i = 0; i < NUM_STAT_COUNTERS; ++i)
+		into->counters[i] += from->counters[i];
+	for(size_t i = 0; i < NUM_STAT_TIMERS; ++i)
+	{
+		into->timer_calls[i] += from->timer_calls[i];
+		into->timer_cycles[i] += from->timer_cycles[i];
+	}
+	return;
+}
+/*********************************************************************
+* void stats_register_thread(void)
+*
+* 	PURPOSE ::
+*  		make the calling thread's counters visible to
+*  		stats_collect()
+*  			-call once at the top of every worker, and
+*  			stats_unregister_thread() before it returns
+*  			-threads past STATS_MAX_THREADS count but are
+*  			not merged
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void stats_register_thread(void)
+{
+	pthread_mutex_lock(&stats_lock);
+	short found = FALSE;
+	for(size_t i = 0; i < stats_num_threads; ++i)
+		if(stats_threads[i] == &thread_stats)
+			found = TRUE;
+	if(!found && stats_num_threads < STATS_MAX_THREADS)
+		stats_threads[stats_num_threads++] = &thread_stats;
+	pthread_mutex_unlock(&stats_lock);
+	return;
+}
+/*********************************************************************
+* void stats_unregister_thread(void)
+*
+* 	PURPOSE ::
+*  		fold the calling thread's counters into the retired
+*  		totals, its thread-local copy dies with it
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void stats_unregister_thread(void)
+{
+	pthread_mutex_lock(&stats_lock);
+	for(size_t i = 0; i < stats_num_threads; ++i)
+		if(stats_threads[i] == &thread_stats)
+		{
+			stats_add(&stats_retired, &thread_stats);
+			stats_retired.threads++;
+			stats_threads[i] = stats_threads[--stats_num_threads];
+			break;
+		}
+	pthread_mutex_unlock(&stats_lock);
+	return;
+}
+/*********************************************************************
+* void stats_collect(Engine_Stats* merged)
+*
+* 	PURPOSE ::
+*  		sum the counters of every registered thread, live or
+*  		finished
+*  			-threads still running are read without stopping
+*  			them, their numbers may be a few increments stale
+*
+* 	@param
+*	 - merged :: overwritten with the totals
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void stats_collect(Engine_Stats* merged)
+{
+	pthread_mutex_lock(&stats_lock);
+	*merged = stats_retired;
+	for(size_t i = 0; i < stats_num_threads; ++i)
+		stats_add(merged, stats_threads[i]);
+	merged->threads += stats_num_threads;
+	pthread_mutex_unlock(&stats_lock);
+	return;
+}
+/*********************************************************************
+* void stats_reset(void)
+*
+* 	PURPOSE ::
+*  		zero the retired totals and every registered thread
+*  			-meant for between searches, a thread counting at
+*  			the same moment may keep an increment or two
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void stats_reset(void)
+{
+	pthread_mutex_lock(&stats_lock);
+	memset(&stats_retired, 0, sizeof(stats_retired));
+	for(size_t i = 0; i < stats_num_threads; ++i)
+		memset(stats_threads[i], 0, sizeof(Engine_Stats));
+	pthread_mutex_unlock(&stats_lock);
+	return;
+}
+/*********************************************************************
+* static double stats_ratio(unsigned long long part,
+*		unsigned long long whole)
+*
+* 	PURPOSE ::
+*  		part / whole, 0 when there is no whole
+*********************************************************************/
+static double stats_ratio(unsigned long long part, unsigned long long whole)
+{
+	return whole ? (double)part / (double)whole : 0.0;
+}
+/*********************************************************************
+* void stats_print(FILE* out, const Engine_Stats* stats)
+*
+* 	PURPOSE ::
+*  		human readable table of <stats>
+*
+* 	@param
+*	 - out   :: where to print
+*	 - stats :: from stats_collect()
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void stats_print(FILE* out, const Engine_Stats* stats)
+{
+#ifndef ENGINE_STATS
+	fprintf(out, "statistics are compiled out, rebuild with -DENGINE_STATS\n");
+#endif
+	fprintf(out, "threads            : %zu\n", stats->threads);
+	for(size_t i = 0; i < NUM_STAT_COUNTERS; ++i)
+		fprintf(out, "%-19s: %llu\n", stat_counter_names[i], stats->counters[i]);
+
+	const unsigned long long* c = stats->counters;
+	fprintf(out, "tt hit rate        : %.1f%%\n", 100.0 * stats_ratio(c[STAT_TT_HITS], c[STAT_TT_PROBES]));
+	fprintf(out, "first move cutoffs : %.1f%%\n", 100.0 * stats_ratio(c[STAT_FIRST_MOVE_CUTOFFS], c[STAT_CUTOFFS]));
+	fprintf(out, "cache hit rate     : %.1f%%\n", 100.0 * stats_ratio(c[STAT_CACHE_HITS], c[STAT_CACHE_PROBES]));
+	fprintf(out, "qnode share        : %.1f%%\n", 100.0 * stats_ratio(c[STAT_QNODES], c[STAT_NODES] + c[STAT_QNODES]));
+
+#ifdef ENGINE_STATS_TIMERS
+	for(size_t i = 0; i < NUM_STAT_TIMERS; ++i)
+		fprintf(out, "%-12s timer    : %llu calls, %.1f cycles/call\n", stat_timer_names[i],
+				stats->timer_calls[i], stats_ratio(stats->timer_cycles[i], stats->timer_calls[i]));
+#endif
+	return;
+}
+/*********************************************************************
+* void stats_dump_json(FILE* out, const Engine_Stats* stats)
+*
+* 	PURPOSE ::
+*  		<stats> as one JSON object, for scripts and dashboards
+*  			-"enabled" / "timers" say what the build counted,
+*  			a compiled-out build reports zeros
+*
+* 	@param
+*	 - out   :: where to write
+*	 - stats :: from stats_collect()
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void stats_dump_json(FILE* out, const Engine_Stats* stats)
+{
+#ifdef ENGINE_STATS
+	const char* enabled = "true";
+#else
+	const char* enabled = "false";
+#endif
+#ifdef ENGINE_STATS_TIMERS
+	const char* timers = "true";
+#else
+	const char* timers = "false";
+#endif
+	const unsigned long long* c = stats->counters;
+
+	fprintf(out, "{\"enabled\":%s,\"timers_enabled\":%s,\"threads\":%zu,\"counters\":{",
+			enabled, timers, stats->threads);
+	for(size_t i = 0; i < NUM_STAT_COUNTERS; ++i)
+		fprintf(out, "%s\"%s\":%llu", i ? "," : "", stat_counter_names[i], c[i]);
+
+	fprintf(out, "},\"rates\":{\"tt_hit\":%.6f,\"first_move_cutoff\":%.6f,\"cache_hit\":%.6f}",
+			stats_ratio(c[STAT_TT_HITS], c[STAT_TT_PROBES]),
+			stats_ratio(c[STAT_FIRST_MOVE_CUTOFFS], c[STAT_CUTOFFS]),
+			stats_ratio(c[STAT_CACHE_HITS], c[STAT_CACHE_PROBES]));
+
+	fprintf(out, ",\"timers\":{");
+	for(size_t i = 0; i < NUM_STAT_TIMERS; ++i)
+		fprintf(out, "%s\"%s\":{\"calls\":%llu,\"cycles\":%llu}", i ? "," : "",
+				stat_timer_names[i], stats->timer_calls[i], stats->timer_cycles[i]);
+	fprintf(out, "}}\n");
+	return;
+}
+#endif //STATS_IMPLEMENTATION_
+#endif //STATS_H_
@@ -0,0 +1,210 @@
+#ifndef TIME_MANAGER_H_
+#define TIME_MANAGER_H_
+
+///user defined
+#include "position.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+//kept back from every budget for move output and scheduling jitter
+#define TIME_OVERHEAD_MS 5
+//nodes between clock reads, a read costs ~20ns so this keeps it in the noise
+#define TIME_CHECK_NODES 1024
+//moves left when the clock gives no movestogo
+#define TIME_MOVES_HORIZON 30
+
+//what the caller knows about the clock, in milliseconds, 0 for unset.
+//movetime wins over the clock fields when both are given
+typedef struct Time_Control
+{
+	long long wtime;
+	long long btime;
+	long long winc;
+	long long binc;
+	int movestogo;
+	long long movetime;		//fixed per-request budget
+} Time_Control;
+
+typedef struct Time_Manager
+{
+	unsigned long long start_ns;
+	unsigned long long soft_ns;	//no new iteration after this, before scaling
+	unsigned long long hard_ns;	//abort the search here, whatever happens
+	unsigned long long check_nodes;	//clock read interval
+
+	double scale;			//stability / score-drop factor on soft_ns
+	unsigned short last_best;	//move_pack() of the last iteration's move
+	int last_score;
+	int stable_iterations;
+	int iterations;
+} Time_Manager;
+
+void time_manager_start(Time_Manager* tm, const Time_Control* tc, char side);
+unsigned long long time_manager_elapsed_ns(const Time_Manager* tm);
+int time_manager_hard_expired(const Time_Manager* tm);
+int time_manager_iteration_done(Time_Manager* tm, unsigned short best, int score);
+
+#ifdef TIME_MANAGER_IMPLEMENTATION_
+
+#define TIME_MS_TO_NS(ms) ((unsigned long long)(ms) * 1000000ULL)
+
+/*********************************************************************
+* void time_manager_start(Time_Manager* tm, const Time_Control* tc,
+*		char side)
+*
+* 	PURPOSE ::
+*  		start the clock and work out the limits for one search
+*  			-fixed budget : hard is the budget less the
+*  			overhead, soft is half of it, an iteration begun
+*  			later would rarely finish in time
+*  			-clock : a 1/movestogo share of the time left
+*  			plus most of the increment, hard at most four
+*  			shares and never more than a fifth of the clock,
+*  			nor more than the clock holds now
+*
+* 	@param
+*	 - tm   :: overwritten
+*	 - tc   :: clock or budget, see Time_Control
+*	 - side :: WHITE or BLACK, whose clock to read
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void time_manager_start(Time_Manager* tm, const Time_Control* tc, char side)
+{
+	memset(tm, 0, sizeof(*tm));
+	tm->start_ns = time_now_ns();
+	tm->check_nodes = TIME_CHECK_NODES;
+	tm->scale = 1.0;
+
+	long long soft_ms;
+	long long hard_ms;
+	if(tc->movetime > 0)
+	{
+		hard_ms = tc->movetime - TIME_OVERHEAD_MS;
+		soft_ms = hard_ms / 2;
+	}
+	else
+	{
+		long long left = (side == WHITE) ? tc->wtime : tc->btime;
+		long long inc  = (side == WHITE) ? tc->winc  : tc->binc;
+		int moves = (tc->movestogo > 0) ? tc->movestogo : TIME_MOVES_HORIZON;
+		if(moves > TIME_MOVES_HORIZON)
+			moves = TIME_MOVES_HORIZON;
+
+		long long usable = left - TIME_OVERHEAD_MS;
+		soft_ms = usable / moves + inc * 3 / 4;
+		hard_ms = soft_ms * 4;
+		//with one move to go the whole clock is fair game, otherwise
+		//never bet more than a fifth of it on one move
+		long long cap = (moves == 1) ? usable : usable / 5 + inc;
+		if(hard_ms > cap)
+			hard_ms = cap;
+		//the increment only arrives after the move, it cannot pay
+		//for more than is on the clock now
+		if(hard_ms > usable)
+			hard_ms = usable;
+		if(soft_ms > hard_ms)
+			soft_ms = hard_ms;
+	}
+
+	if(hard_ms < 1)
+		hard_ms = 1;
+	if(soft_ms < 1)
+		soft_ms = 1;
+	tm->soft_ns = TIME_MS_TO_NS(soft_ms);
+	tm->hard_ns = TIME_MS_TO_NS(hard_ms);
+	return;
+}
+/*********************************************************************
+* unsigned long long time_manager_elapsed_ns(const Time_Manager* tm)
+*
+* 	PURPOSE ::
+*  		time since time_manager_start()
+*
+* 	@param
+*	 - tm :: running manager
+*
+*	 @return
+*	 - unsigned long long :: nanoseconds
+*********************************************************************/
+unsigned long long time_manager_elapsed_ns(const Time_Manager* tm)
+{
+	return time_now_ns() - tm->start_ns;
+}
+/*********************************************************************
+* int time_manager_hard_expired(const Time_Manager* tm)
+*
+* 	PURPOSE ::
+*  		has the hard limit passed, the search polls this every
+*  		tm->check_nodes nodes and unwinds when it has
+*
+* 	@param
+*	 - tm :: running manager
+*
+*	 @return
+*	 - TRUE  :: stop now
+*	 - FALSE :: keep searching
+*********************************************************************/
+int time_manager_hard_expired(const Time_Manager* tm)
+{
+	return time_manager_elapsed_ns(tm) >= tm->hard_ns;
+}
+/*********************************************************************
+* int time_manager_iteration_done(Time_Manager* tm, unsigned short best,
+*		int score)
+*
+* 	PURPOSE ::
+*  		called after each completed iteration, decide whether
+*  		to start another
+*  			-a best move that keeps changing stretches the
+*  			soft limit, one that holds for several
+*  			iterations shrinks it
+*  			-a score falling from the last iteration
+*  			stretches it further, trouble deserves time
+*  			-the stretched limit never passes the hard one
+*
+* 	@param
+*	 - tm    :: running manager
+*	 - best  :: move_pack() of the iteration's best move
+*	 - score :: its score
+*
+*	 @return
+*	 - TRUE  :: stop, return this iteration's move
+*	 - FALSE :: go one deeper
+*********************************************************************/
+int time_manager_iteration_done(Time_Manager* tm, unsigned short best, int score)
+{
+	if(tm->iterations > 0)
+	{
+		if(best == tm->last_best)
+			tm->stable_iterations++;
+		else
+			tm->stable_iterations = 0;
+
+		//1.5 right after a change, down to 0.6 once settled
+		double scale = 1.5 - 0.15 * tm->stable_iterations;
+		if(scale < 0.6)
+			scale = 0.6;
+
+		int drop = tm->last_score - score;
+		if(drop > 60)
+			scale *= 1.6;
+		else if(drop > 25)
+			scale *= 1.25;
+		tm->scale = scale;
+	}
+	tm->iterations++;
+	tm->last_best = best;
+	tm->last_score = score;
+
+	unsigned long long soft = (unsigned long long)((double)tm->soft_ns * tm->scale);
+	if(soft > tm->hard_ns)
+		soft = tm->hard_ns;
+	return time_manager_elapsed_ns(tm) >= soft;
+}
+#endif //TIME_MANAGER_IMPLEMENTATION_
+#endif //TIME_MANAGER_H_
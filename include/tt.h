@@ -0,0 +1,246 @@
+#ifndef TT_H_
+#define TT_H_
+
+///user defined
+#include "stats.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TT_BUCKET 4	//entries probed per key
+
+typedef enum Tt_Bound
+{
+	TT_NONE = 0,
+	TT_EXACT,
+	TT_LOWER,	//score is at least this (beta cutoff)
+	TT_UPPER	//score is at most this (nothing beat alpha)
+} Tt_Bound;
+
+//the key is stored xor-ed with the data, so a slot torn by two
+//threads writing at once just fails to match instead of lying
+typedef struct Tt_Entry
+{
+	unsigned long long check;
+	unsigned long long data;
+} Tt_Entry;
+
+typedef struct Tt_Hit
+{
+	unsigned short move;	//move_pack(), 0 for none
+	short score;
+	signed char depth;
+	unsigned char bound;	//Tt_Bound
+} Tt_Hit;
+
+typedef struct Transposition_Table
+{
+	Tt_Entry* entries;
+	size_t mask;		//bucket count - 1
+	unsigned char age;
+} Transposition_Table;
+
+Transposition_Table* tt_create(size_t memory_bytes);
+void tt_destroy(Transposition_Table* tt);
+void tt_clear(Transposition_Table* tt);
+void tt_new_search(Transposition_Table* tt);
+int tt_probe(const Transposition_Table* tt, unsigned long long key, Tt_Hit* hit);
+void tt_store(Transposition_Table* tt, unsigned long long key, unsigned short move,
+		short score, signed char depth, Tt_Bound bound);
+
+#ifdef TT_IMPLEMENTATION_
+
+//data word : move (16) | score (16) | depth (8) | bound (8) | age (8)
+#define TT_PACK(move, score, depth, bound, age) \
+	(  (unsigned long long)(unsigned short)(move) \
+	| ((unsigned long long)(unsigned short)(score) << 16) \
+	| ((unsigned long long)(unsigned char)(depth) << 32) \
+	| ((unsigned long long)(unsigned char)(bound) << 40) \
+	| ((unsigned long long)(unsigned char)(age)   << 48))
+#define TT_MOVE(data)  ((unsigned short)(data))
+#define TT_SCORE(data) ((short)((data) >> 16))
+#define TT_DEPTH(data) ((signed char)((data) >> 32))
+#define TT_BOUND(data) ((unsigned char)((data) >> 40))
+#define TT_AGE(data)   ((unsigned char)((data) >> 48))
+
+/*********************************************************************
+* Transposition_Table* tt_create(size_t memory_bytes)
+*
+* 	PURPOSE ::
+*  		allocate a table using at most <memory_bytes>
+*
+* 	@param
+*	 - memory_bytes :: budget, rounded down to a power of two
+*	 		   number of buckets
+*
+*	 @return
+*	 - NULL :: on failure
+*	 - tt   :: newly created, empty table
+*********************************************************************/
+Transposition_Table* tt_create(size_t memory_bytes)
+{
+	size_t buckets = 1;
+	while(buckets * 2 * TT_BUCKET * sizeof(Tt_Entry) <= memory_bytes)
+		buckets *= 2;
+
+	Transposition_Table* tt = (Transposition_Table*)malloc(sizeof(Transposition_Table));
+	if(!tt)
+		return NULL;
+	tt->entries = (Tt_Entry*)calloc(buckets * TT_BUCKET, sizeof(Tt_Entry));
+	if(!tt->entries)
+	{
+		free(tt);
+		return NULL;
+	}
+	tt->mask = buckets - 1;
+	tt->age = 0;
+	return tt;
+}
+/*********************************************************************
+* void tt_destroy(Transposition_Table* tt)
+*
+* 	PURPOSE ::
+*  		free <tt>
+*
+* 	@param
+*	 - tt :: table to free
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void tt_destroy(Transposition_Table* tt)
+{
+	if(!tt)
+		return;
+	free(tt->entries);
+	free(tt);
+	return;
+}
+/*********************************************************************
+* void tt_clear(Transposition_Table* tt)
+*
+* 	PURPOSE ::
+*  		forget everything, e.g. between unrelated games
+*
+* 	@param
+*	 - tt :: table to wipe
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void tt_clear(Transposition_Table* tt)
+{
+	memset(tt->entries, 0, (tt->mask + 1) * TT_BUCKET * sizeof(Tt_Entry));
+	tt->age = 0;
+	return;
+}
+/*********************************************************************
+* void tt_new_search(Transposition_Table* tt)
+*
+* 	PURPOSE ::
+*  		age the table, entries from older searches are the
+*  		first to be replaced
+*
+* 	@param
+*	 - tt :: table to age
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void tt_new_search(Transposition_Table* tt)
+{
+	tt->age++;
+	return;
+}
+/*********************************************************************
+* int tt_probe(const Transposition_Table* tt, unsigned long long key,
+*		Tt_Hit* hit)
+*
+* 	PURPOSE ::
+*  		look <key> up
+*
+* 	@param
+*	 - tt  :: table to search
+*	 - key :: position hash
+*	 - hit :: receives the stored move / score / depth / bound
+*
+*	 @return
+*	 - TRUE  :: found
+*	 - FALSE :: not stored
+*********************************************************************/
+int tt_probe(const Transposition_Table* tt, unsigned long long key, Tt_Hit* hit)
+{
+	STAT_INC(STAT_TT_PROBES);
+	const Tt_Entry* bucket = &tt->entries[(key & tt->mask) * TT_BUCKET];
+	for(size_t i = 0; i < TT_BUCKET; ++i)
+	{
+		unsigned long long data = bucket[i].data;
+		if((bucket[i].check ^ data) != key || TT_BOUND(data) == TT_NONE)
+			continue;
+		hit->move  = TT_MOVE(data);
+		hit->score = TT_SCORE(data);
+		hit->depth = TT_DEPTH(data);
+		hit->bound = TT_BOUND(data);
+		STAT_INC(STAT_TT_HITS);
+		return TRUE;
+	}
+	return FALSE;
+}
+/*********************************************************************
+* void tt_store(Transposition_Table* tt, unsigned long long key,
+*		unsigned short move, short score, signed char depth,
+*		Tt_Bound bound)
+*
+* 	PURPOSE ::
+*  		remember a search result for <key>
+*  			-reuses the slot already holding <key>, otherwise
+*  			replaces the shallowest entry, older searches first
+*
+* 	@param
+*	 - tt    :: table to fill
+*	 - key   :: position hash
+*	 - move  :: best move found, packed, 0 for none
+*	 - score :: search score
+*	 - depth :: remaining depth it was searched to
+*	 - bound :: how <score> relates to the true value
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void tt_store(Transposition_Table* tt, unsigned long long key, unsigned short move,
+		short score, signed char depth, Tt_Bound bound)
+{
+	Tt_Entry* bucket = &tt->entries[(key & tt->mask) * TT_BUCKET];
+	Tt_Entry* victim = &bucket[0];
+	int victim_worth = 1 << 30;
+
+	for(size_t i = 0; i < TT_BUCKET; ++i)
+	{
+		unsigned long long data = bucket[i].data;
+		if((bucket[i].check ^ data) == key)
+		{
+			//keep the old best move if this search found none
+			if(move == 0)
+				move = TT_MOVE(data);
+			victim = &bucket[i];
+			break;
+		}
+		int worth = TT_DEPTH(data) - ((TT_AGE(data) != tt->age) ? 64 : 0);
+		if(TT_BOUND(data) == TT_NONE)
+			worth = -(1 << 20);
+		if(worth < victim_worth)
+		{
+			victim_worth = worth;
+			victim = &bucket[i];
+		}
+	}
+
+	unsigned long long data = TT_PACK(move, score, depth, bound, tt->age);
+	victim->data = data;
+	victim->check = key ^ data;
+	return;
+}
+#endif //TT_IMPLEMENTATION_
+#endif //TT_H_
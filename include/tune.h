@@ -0,0 +1,621 @@
+#ifndef TUNE_H_
+#define TUNE_H_
+
+///user defined
+#include "position.h"
+#include "position_pack.h"
+#include "self_play.h"
+#include "fen.h"
+#include "eval.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+//material counts are padded to this many lanes so the dot product
+//is one fixed-width vector operation
+#define TUNE_LANES 8
+//set on a square feature when the piece is black
+#define TUNE_BLACK 0x8000
+
+//every labelled position, flattened for the tuner.
+//a position is its material balance plus one entry per piece,
+//kind * 64 + square (mirrored for black) | TUNE_BLACK
+typedef struct Tune_Set
+{
+	size_t count;
+	size_t capacity;
+	float* target;			//expected result for white, 0 .. 1
+	signed char (*material)[TUNE_LANES];	//white minus black, per kind
+	size_t* offset;			//count + 1 starts into squares
+	unsigned short* squares;
+	size_t squares_capacity;
+} Tune_Set;
+
+typedef struct Tune_Config
+{
+	size_t num_threads;		//0 for one per core
+	int epochs;
+	double learning_rate;		//Adam step, in centipawns
+	double k;			//sigmoid scale, 0 to fit it first
+	int report_every;		//print the error every N epochs, 0 never
+} Tune_Config;
+
+void tune_defaults(Tune_Config* config);
+void tune_set_init(Tune_Set* set);
+void tune_set_free(Tune_Set* set);
+void tune_set_add(Tune_Set* set, const Position* pos, double target);
+long tune_load_self_play(Tune_Set* set, const char* path);
+long tune_load_epd(Tune_Set* set, const char* path);
+double tune_error(const Tune_Set* set, const Eval_Params* params, double k, size_t num_threads);
+double tune_find_k(const Tune_Set* set, const Eval_Params* params, size_t num_threads);
+double tune_run(const Tune_Set* set, Eval_Params* params, const Tune_Config* config);
+
+#ifdef TUNE_IMPLEMENTATION_
+
+//one thread's slice of a pass over the set
+typedef struct Tune_Job
+{
+	const Tune_Set* set;
+	const double* weights;		//material then square tables, as Eval_Params
+	double scale;			//k * ln(10) / 400
+	size_t begin;
+	size_t end;
+	short want_gradient;
+
+	double error;
+	double gradient[EVAL_NUM_PARAMS];
+} Tune_Job;
+
+/*********************************************************************
+* void tune_defaults(Tune_Config* config)
+*
+* 	PURPOSE ::
+*  		fill <config> with settings that converge on a few
+*  		million positions
+*
+* 	@param
+*	 - config :: overwritten
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void tune_defaults(Tune_Config* config)
+{
+	config->num_threads = 0;
+	config->epochs = 200;
+	config->learning_rate = 1.0;
+	config->k = 0.0;
+	config->report_every = 10;
+	return;
+}
+/*********************************************************************
+* void tune_set_init(Tune_Set* set)
+*
+* 	PURPOSE ::
+*  		start an empty set
+*
+* 	@param
+*	 - set :: overwritten
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void tune_set_init(Tune_Set* set)
+{
+	memset(set, 0, sizeof(*set));
+	set->capacity = 1024;
+	set->squares_capacity = 32 * set->capacity;
+	set->target   = (float*)malloc(set->capacity * sizeof(float));
+	set->material = (signed char(*)[TUNE_LANES])malloc(set->capacity * TUNE_LANES);
+	set->offset   = (size_t*)malloc((set->capacity + 1) * sizeof(size_t));
+	set->squares  = (unsigned short*)malloc(set->squares_capacity * sizeof(unsigned short));
+	if(!set->target || !set->material || !set->offset || !set->squares)
+		error_nomem();
+	set->offset[0] = 0;
+	return;
+}
+/*********************************************************************
+* void tune_set_free(Tune_Set* set)
+*
+* 	PURPOSE ::
+*  		release everything tune_set_init() and tune_set_add()
+*  		allocated
+*
+* 	@param
+*	 - set :: set to empty
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void tune_set_free(Tune_Set* set)
+{
+	free(set->target);
+	free(set->material);
+	free(set->offset);
+	free(set->squares);
+	memset(set, 0, sizeof(*set));
+	return;
+}
+/*********************************************************************
+* void tune_set_add(Tune_Set* set, const Position* pos, double target)
+*
+* 	PURPOSE ::
+*  		flatten <pos> into <set>
+*
+* 	@param
+*	 - set    :: set to grow
+*	 - pos    :: labelled position
+*	 - target :: 1 white won, 0.5 draw, 0 black won
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void tune_set_add(Tune_Set* set, const Position* pos, double target)
+{
+	if(set->count == set->capacity)
+	{
+		set->capacity *= 2;
+		set->target   = (float*)realloc(set->target, set->capacity * sizeof(float));
+		set->material = (signed char(*)[TUNE_LANES])realloc(set->material, set->capacity * TUNE_LANES);
+		set->offset   = (size_t*)realloc(set->offset, (set->capacity + 1) * sizeof(size_t));
+		if(!set->target || !set->material || !set->offset)
+			error_nomem();
+	}
+	if(set->offset[set->count] + NUM_ROWS * NUM_COLS > set->squares_capacity)
+	{
+		set->squares_capacity *= 2;
+		set->squares = (unsigned short*)realloc(set->squares, set->squares_capacity * sizeof(unsigned short));
+		if(!set->squares)
+			error_nomem();
+	}
+
+	signed char* material = set->material[set->count];
+	memset(material, 0, TUNE_LANES);
+	size_t next = set->offset[set->count];
+	for(size_t row = 0; row < NUM_ROWS; ++row)
+		for(size_t col = 0; col < NUM_COLS; ++col)
+		{
+			char piece = pos->squares[row][col];
+			int kind = piece_kind(piece);
+			if(kind == FAILURE)
+				continue;
+			if(isupper(piece))
+			{
+				material[kind]++;
+				set->squares[next++] = (unsigned short)(kind * NUM_ROWS * NUM_COLS + row * NUM_COLS + col);
+			}
+			else
+			{
+				material[kind]--;
+				set->squares[next++] = (unsigned short)(kind * NUM_ROWS * NUM_COLS
+						+ (NUM_ROWS - 1 - row) * NUM_COLS + col) | TUNE_BLACK;
+			}
+		}
+
+	set->target[set->count] = (float)target;
+	set->offset[++set->count] = next;
+	return;
+}
+/*********************************************************************
+* long tune_load_self_play(Tune_Set* set, const char* path)
+*
+* 	PURPOSE ::
+*  		add every position of a self_play_run() output file,
+*  		labelled with the result of its game
+*
+* 	@param
+*	 - set  :: set to grow
+*	 - path :: Self_Play_Record file
+*
+*	 @return
+*	 - FAILURE :: could not read <path>
+*	 - long    :: positions added
+*********************************************************************/
+long tune_load_self_play(Tune_Set* set, const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if(!file)
+	{
+		perror("Could not open self-play file\n\t{tune_load_self_play}\n");
+		return FAILURE;
+	}
+
+	Self_Play_Record records[1024];
+	long added = 0;
+	size_t read;
+	while((read = fread(records, sizeof(Self_Play_Record), 1024, file)) > 0)
+		for(size_t i = 0; i < read; ++i)
+		{
+			Position pos;
+			if(position_unpack(&records[i].position, &pos) != 0)
+				continue;
+			tune_set_add(set, &pos, (records[i].result + 1) * 0.5);
+			added++;
+		}
+	fclose(file);
+	return added;
+}
+/*********************************************************************
+* long tune_load_epd(Tune_Set* set, const char* path)
+*
+* 	PURPOSE ::
+*  		add every position of an EPD / FEN file whose line
+*  		carries a result, as a bare token or the value of an
+*  		opcode : 1-0, 0-1, 1/2-1/2, or [1.0] / [0.5] / [0.0]
+*  			-lines without a result are skipped
+*
+* 	@param
+*	 - set  :: set to grow
+*	 - path :: text file, one position per line
+*
+*	 @return
+*	 - FAILURE :: could not read <path>
+*	 - long    :: positions added
+*********************************************************************/
+long tune_load_epd(Tune_Set* set, const char* path)
+{
+	FILE* file = fopen(path, "r");
+	if(!file)
+	{
+		perror("Could not open EPD file\n\t{tune_load_epd}\n");
+		return FAILURE;
+	}
+
+	char line[512];
+	long added = 0;
+	size_t skipped = 0;
+	while(fgets(line, sizeof(line), file))
+	{
+		if(line[0] == '\n' || line[0] == '#')
+			continue;
+
+		Position pos;
+		double target = -1.0;
+		if(position_from_fen(&pos, line) == 0)
+		{
+			//board and side first, so a result there can't be misread
+			const char* rest = strchr(line, ' ');
+			if(rest)
+				rest = strchr(rest + 1, ' ');
+			if(rest && strstr(rest, "1/2-1/2"))
+				target = 0.5;
+			else if(rest && strstr(rest, "1-0"))
+				target = 1.0;
+			else if(rest && strstr(rest, "0-1"))
+				target = 0.0;
+			else if(rest && (rest = strchr(rest, '[')))
+				target = atof(rest + 1);
+		}
+
+		if(target < 0.0 || target > 1.0)
+		{
+			skipped++;
+			continue;
+		}
+		tune_set_add(set, &pos, target);
+		added++;
+	}
+	fclose(file);
+
+	if(skipped)
+		fprintf(stderr, "Skipped %zu unlabelled lines in %s\n", skipped, path);
+	return added;
+}
+/*********************************************************************
+* static void tune_params_to_weights(const Eval_Params* params,
+*		double* weights)
+*
+* 	PURPOSE ::
+*  		Eval_Params is material then square tables, all int,
+*  		the tuner works on the same layout in double
+*********************************************************************/
+static void tune_params_to_weights(const Eval_Params* params, double* weights)
+{
+	const int* values = &params->material[0];
+	for(size_t i = 0; i < NUM_PIECE_KINDS; ++i)
+		weights[i] = values[i];
+	values = &params->pst[0][0];
+	for(size_t i = 0; i < NUM_PIECE_KINDS * NUM_ROWS * NUM_COLS; ++i)
+		weights[NUM_PIECE_KINDS + i] = values[i];
+	return;
+}
+/*********************************************************************
+* static void tune_weights_to_params(const double* weights,
+*		Eval_Params* params)
+*
+* 	PURPOSE ::
+*  		round the tuner's weights back into <params>
+*********************************************************************/
+static void tune_weights_to_params(const double* weights, Eval_Params* params)
+{
+	for(size_t i = 0; i < NUM_PIECE_KINDS; ++i)
+		params->material[i] = (int)lround(weights[i]);
+	int* values = &params->pst[0][0];
+	for(size_t i = 0; i < NUM_PIECE_KINDS * NUM_ROWS * NUM_COLS; ++i)
+		values[i] = (int)lround(weights[NUM_PIECE_KINDS + i]);
+	return;
+}
+/*********************************************************************
+* static void* tune_worker(void* arg)
+*
+* 	PURPOSE ::
+*  		squared error of the sigmoid of the evaluation against
+*  		the result, and its gradient, over one slice
+*  			-the material term is a TUNE_LANES wide dot
+*  			product the compiler vectorises, the square terms
+*  			are a gather of about 30 entries
+*  			-the gradient leaves out the constant factor
+*  			2 * scale / count, tune_pass() applies it
+*********************************************************************/
+static void* tune_worker(void* arg)
+{
+	Tune_Job* job = (Tune_Job*)arg;
+	const Tune_Set* set = job->set;
+	const double* material_weights = job->weights;
+	const double* square_weights = job->weights + NUM_PIECE_KINDS;
+
+	double lanes[TUNE_LANES] = { 0 };
+	for(size_t kind = 0; kind < NUM_PIECE_KINDS; ++kind)
+		lanes[kind] = material_weights[kind];
+
+	double error = 0.0;
+	memset(job->gradient, 0, sizeof(job->gradient));
+	for(size_t i = job->begin; i < job->end; ++i)
+	{
+		const signed char* material = set->material[i];
+		double score = 0.0;
+		for(size_t lane = 0; lane < TUNE_LANES; ++lane)
+			score += lanes[lane] * material[lane];
+
+		const unsigned short* squares = &set->squares[set->offset[i]];
+		const size_t count = set->offset[i + 1] - set->offset[i];
+		for(size_t s = 0; s < count; ++s)
+		{
+			double weight = square_weights[squares[s] & ~TUNE_BLACK];
+			score += (squares[s] & TUNE_BLACK) ? -weight : weight;
+		}
+
+		double sigmoid = 1.0 / (1.0 + exp(-job->scale * score));
+		double diff = sigmoid - set->target[i];
+		error += diff * diff;
+		if(!job->want_gradient)
+			continue;
+
+		double slope = diff * sigmoid * (1.0 - sigmoid);
+		for(size_t kind = 0; kind < NUM_PIECE_KINDS; ++kind)
+			job->gradient[kind] += slope * material[kind];
+		for(size_t s = 0; s < count; ++s)
+		{
+			size_t index = NUM_PIECE_KINDS + (squares[s] & ~TUNE_BLACK);
+			job->gradient[index] += (squares[s] & TUNE_BLACK) ? -slope : slope;
+		}
+	}
+	job->error = error;
+	return NULL;
+}
+/*********************************************************************
+* static double tune_pass(const Tune_Set* set, const double* weights,
+*		double k, size_t num_threads, double* gradient)
+*
+* 	PURPOSE ::
+*  		one pass over the whole set split across threads,
+*  		returns the mean squared error
+*  			-<gradient> may be NULL when only the error is
+*  			wanted
+*********************************************************************/
+static double tune_pass(const Tune_Set* set, const double* weights, double k,
+		size_t num_threads, double* gradient)
+{
+	if(set->count == 0)
+		return 0.0;
+	if(num_threads > set->count)
+		num_threads = set->count;
+
+	Tune_Job* jobs = (Tune_Job*)malloc(num_threads * sizeof(Tune_Job));
+	pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+	if(!jobs || !threads)
+		error_nomem();
+
+	const double scale = k * log(10.0) / 400.0;
+	const size_t slice = (set->count + num_threads - 1) / num_threads;
+	for(size_t t = 0; t < num_threads; ++t)
+	{
+		jobs[t].set = set;
+		jobs[t].weights = weights;
+		jobs[t].scale = scale;
+		jobs[t].begin = t * slice;
+		jobs[t].end = (t + 1) * slice < set->count ? (t + 1) * slice : set->count;
+		jobs[t].want_gradient = (gradient != NULL);
+	}
+
+	//the calling thread takes the first slice itself, and any slice
+	//whose thread would not start
+	size_t started = 0;
+	for(size_t t = 1; t < num_threads; ++t)
+		if(pthread_create(&threads[started], NULL, tune_worker, &jobs[t]) == 0)
+			started++;
+		else
+			tune_worker(&jobs[t]);
+	tune_worker(&jobs[0]);
+	for(size_t t = 0; t < started; ++t)
+		pthread_join(threads[t], NULL);
+
+	double error = 0.0;
+	if(gradient)
+		memset(gradient, 0, EVAL_NUM_PARAMS * sizeof(double));
+	for(size_t t = 0; t < num_threads; ++t)
+	{
+		error += jobs[t].error;
+		for(size_t i = 0; gradient && i < EVAL_NUM_PARAMS; ++i)
+			gradient[i] += jobs[t].gradient[i];
+	}
+	for(size_t i = 0; gradient && i < EVAL_NUM_PARAMS; ++i)
+		gradient[i] *= 2.0 * scale / (double)set->count;
+
+	free(threads);
+	free(jobs);
+	return error / (double)set->count;
+}
+/*********************************************************************
+* static size_t tune_threads(size_t requested)
+*
+* 	PURPOSE ::
+*  		0 means one thread per core
+*********************************************************************/
+static size_t tune_threads(size_t requested)
+{
+	if(requested)
+		return requested;
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	return (cores > 0) ? (size_t)cores : 1;
+}
+/*********************************************************************
+* double tune_error(const Tune_Set* set, const Eval_Params* params,
+*		double k, size_t num_threads)
+*
+* 	PURPOSE ::
+*  		mean squared error of <params> over <set>
+*
+* 	@param
+*	 - set         :: labelled positions
+*	 - params      :: weights to score
+*	 - k           :: sigmoid scale
+*	 - num_threads :: 0 for one per core
+*
+*	 @return
+*	 - double :: mean of (result - sigmoid(eval))^2
+*********************************************************************/
+double tune_error(const Tune_Set* set, const Eval_Params* params, double k, size_t num_threads)
+{
+	double weights[EVAL_NUM_PARAMS];
+	tune_params_to_weights(params, weights);
+	return tune_pass(set, weights, k, tune_threads(num_threads), NULL);
+}
+/*********************************************************************
+* double tune_find_k(const Tune_Set* set, const Eval_Params* params,
+*		size_t num_threads)
+*
+* 	PURPOSE ::
+*  		the sigmoid scale that best fits <params> as they are,
+*  		found by golden section search over 0.1 .. 4
+*  			-tuning then moves the weights, not the scale
+*
+* 	@param
+*	 - set         :: labelled positions
+*	 - params      :: current weights
+*	 - num_threads :: 0 for one per core
+*
+*	 @return
+*	 - double :: k with the least error
+*********************************************************************/
+double tune_find_k(const Tune_Set* set, const Eval_Params* params, size_t num_threads)
+{
+	const double ratio = (sqrt(5.0) - 1.0) / 2.0;
+	double low = 0.1;
+	double high = 4.0;
+	double a = high - ratio * (high - low);
+	double b = low + ratio * (high - low);
+	double error_a = tune_error(set, params, a, num_threads);
+	double error_b = tune_error(set, params, b, num_threads);
+
+	while(high - low > 0.001)
+	{
+		if(error_a < error_b)
+		{
+			high = b;
+			b = a;
+			error_b = error_a;
+			a = high - ratio * (high - low);
+			error_a = tune_error(set, params, a, num_threads);
+		}
+		else
+		{
+			low = a;
+			a = b;
+			error_a = error_b;
+			b = low + ratio * (high - low);
+			error_b = tune_error(set, params, b, num_threads);
+		}
+	}
+	return (low + high) / 2.0;
+}
+/*********************************************************************
+* double tune_run(const Tune_Set* set, Eval_Params* params,
+*		const Tune_Config* config)
+*
+* 	PURPOSE ::
+*  		Texel tuning : minimise the squared error between
+*  		game results and the sigmoid of the evaluation with
+*  		full-batch Adam
+*  			-the king's material is held at 0, both sides
+*  			always have one
+*
+* 	@param
+*	 - set    :: labelled positions
+*	 - params :: starting weights, replaced by the tuned ones
+*	 - config :: see tune_defaults()
+*
+*	 @return
+*	 - double :: error of the final weights
+*********************************************************************/
+double tune_run(const Tune_Set* set, Eval_Params* params, const Tune_Config* config)
+{
+	const size_t num_threads = tune_threads(config->num_threads);
+	const double k = (config->k > 0.0) ? config->k : tune_find_k(set, params, num_threads);
+	const double beta1 = 0.9;
+	const double beta2 = 0.999;
+	const double epsilon = 1e-8;
+
+	double* weights  = (double*)malloc(EVAL_NUM_PARAMS * sizeof(double));
+	double* gradient = (double*)malloc(EVAL_NUM_PARAMS * sizeof(double));
+	double* moment   = (double*)calloc(EVAL_NUM_PARAMS, sizeof(double));
+	double* velocity = (double*)calloc(EVAL_NUM_PARAMS, sizeof(double));
+	if(!weights || !gradient || !moment || !velocity)
+		error_nomem();
+	tune_params_to_weights(params, weights);
+
+	if(config->report_every)
+		printf("positions %zu, threads %zu, k %.3f\n", set->count, num_threads, k);
+
+	double error = 0.0;
+	double beta1_power = 1.0;
+	double beta2_power = 1.0;
+	for(int epoch = 1; epoch <= config->epochs; ++epoch)
+	{
+		unsigned long long start = time_now_ns();
+		error = tune_pass(set, weights, k, num_threads, gradient);
+		gradient[NUM_PIECE_KINDS - 1] = 0.0;	//king material
+
+		beta1_power *= beta1;
+		beta2_power *= beta2;
+		for(size_t i = 0; i < EVAL_NUM_PARAMS; ++i)
+		{
+			moment[i]   = beta1 * moment[i]   + (1.0 - beta1) * gradient[i];
+			velocity[i] = beta2 * velocity[i] + (1.0 - beta2) * gradient[i] * gradient[i];
+			double m = moment[i] / (1.0 - beta1_power);
+			double v = velocity[i] / (1.0 - beta2_power);
+			weights[i] -= config->learning_rate * m / (sqrt(v) + epsilon);
+		}
+
+		if(config->report_every && epoch % config->report_every == 0)
+			printf("epoch %4d  error %.6f  %.2fs\n", epoch, error,
+					(double)(time_now_ns() - start) / 1e9);
+	}
+
+	tune_weights_to_params(weights, params);
+	error = tune_error(set, params, k, num_threads);
+
+	free(velocity);
+	free(moment);
+	free(gradient);
+	free(weights);
+	return error;
+}
+#endif //TUNE_IMPLEMENTATION_
+#endif //TUNE_H_
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
+#include <time.h>
 
 
 ///user-defined macros
@@ -21,15 +22,16 @@ typedef struct Move
 
 void error_nomem(void);
 void error_noexist(const char* variable, const char* location);
-#if UTIL_IMPLEMENTATION_
+unsigned long long time_now_ns(void);
+#ifdef UTIL_IMPLEMENTATION_
 
 
 void error_noexist(const char* variable, const char* location)
 {
-	assert(variables);
+	assert(variable);
 	assert(location);
 
-	fprintf("Variable %s does not exist at function %s\n", variable, location);
+	fprintf(stderr, "Variable %s does not exist at function %s\n", variable, location);
 	return;
 }
 
@@ -39,6 +41,23 @@ void error_nomem(void)
 	exit(-1);
 }
 
+/*********************************************************************
+* unsigned long long time_now_ns(void)
+*
+* 	PURPOSE ::
+*  		read the monotonic clock, used for latency and 
+*  		throughput measurements
+*
+*	 @return
+*	 - unsigned long long :: nanoseconds since an arbitrary epoch
+*********************************************************************/
+unsigned long long time_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
 
 #endif //UTIL_IMPLEMENTATION_
 #endif //UTIL_H_
@@ -0,0 +1,175 @@
+#ifndef ZOBRIST_H_
+#define ZOBRIST_H_
+
+///user defined
+#include "position.h"
+#include "util.h"
+///standard
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+//piece letters in key order, white first
+#define ZOBRIST_PIECES "PNBRQKpnbrqk"
+#define NUM_PIECE_TYPES 12
+
+//fixed seed, hashes must match across runs and processes
+#define ZOBRIST_SEED 0x9E3779B97F4A7C15ULL
+
+void zobrist_init(void);
+int zobrist_piece_index(char piece);
+unsigned long long zobrist_piece_key(char piece, short row, short col);
+unsigned long long zobrist_side_key(void);
+unsigned long long position_hash(const Position* pos);
+
+#ifdef ZOBRIST_IMPLEMENTATION_
+
+static unsigned long long zobrist_keys[NUM_PIECE_TYPES][NUM_ROWS * NUM_COLS];
+static unsigned long long zobrist_black_to_move;
+static pthread_once_t zobrist_once = PTHREAD_ONCE_INIT;
+
+/*********************************************************************
+* static unsigned long long splitmix64(unsigned long long* state)
+*
+* 	PURPOSE ::
+*  		small, well mixed generator for the key table
+*********************************************************************/
+static unsigned long long splitmix64(unsigned long long* state)
+{
+	unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+/*********************************************************************
+* static void zobrist_fill(void)
+*
+* 	PURPOSE ::
+*  		fill the key table, run exactly once through pthread_once
+*********************************************************************/
+static void zobrist_fill(void)
+{
+	unsigned long long state = ZOBRIST_SEED;
+	for(size_t piece = 0; piece < NUM_PIECE_TYPES; ++piece)
+		for(size_t sq = 0; sq < NUM_ROWS * NUM_COLS; ++sq)
+			zobrist_keys[piece][sq] = splitmix64(&state);
+	zobrist_black_to_move = splitmix64(&state);
+	return;
+}
+/*********************************************************************
+* void zobrist_init(void)
+*
+* 	PURPOSE ::
+*  		make sure the key table exists
+*  			-safe to call from any thread, any number of times,
+*  			position_hash() calls it for you
+*
+*	 @return
+*	 - void :: no need to return anything
+*********************************************************************/
+void zobrist_init(void)
+{
+	pthread_once(&zobrist_once, zobrist_fill);
+	return;
+}
+/*********************************************************************
+* int zobrist_piece_index(char piece)
+*
+* 	PURPOSE ::
+*  		map a piece letter to its row of the key table
+*
+* 	@param
+*	 - piece :: one of ZOBRIST_PIECES
+*
+*	 @return
+*	 - FAILURE :: not a piece ('.' included)
+*	 - index   :: 0 .. NUM_PIECE_TYPES - 1
+*********************************************************************/
+int zobrist_piece_index(char piece)
+{
+	switch(piece)
+	{
+		case 'P': return 0;
+		case 'N': return 1;
+		case 'B': return 2;
+		case 'R': return 3;
+		case 'Q': return 4;
+		case 'K': return 5;
+		case 'p': return 6;
+		case 'n': return 7;
+		case 'b': return 8;
+		case 'r': return 9;
+		case 'q': return 10;
+		case 'k': return 11;
+		default:  return FAILURE;
+	}
+}
+/*********************************************************************
+* unsigned long long zobrist_piece_key(char piece, short row, short col)
+*
+* 	PURPOSE ::
+*  		key to xor in / out when <piece> lands on / leaves
+*  		<row>,<col>, for updating a hash move by move
+*
+* 	@param
+*	 - piece :: piece letter, '.' gives 0
+*	 - row   :: 0 .. 7
+*	 - col   :: 0 .. 7
+*
+*	 @return
+*	 - unsigned long long :: the key
+*********************************************************************/
+unsigned long long zobrist_piece_key(char piece, short row, short col)
+{
+	int index = zobrist_piece_index(piece);
+	if(index == FAILURE)
+		return 0;
+	zobrist_init();
+	return zobrist_keys[index][row * NUM_COLS + col];
+}
+/*********************************************************************
+* unsigned long long zobrist_side_key(void)
+*
+* 	PURPOSE ::
+*  		key xor-ed in while black is to move
+*
+*	 @return
+*	 - unsigned long long :: the key
+*********************************************************************/
+unsigned long long zobrist_side_key(void)
+{
+	zobrist_init();
+	return zobrist_black_to_move;
+}
+/*********************************************************************
+* unsigned long long position_hash(const Position* pos)
+*
+* 	PURPOSE ::
+*  		hash the pieces and side to move of <pos>
+*  			-move clocks are left out, they do not change
+*  			which moves are legal
+*
+* 	@param
+*	 - pos :: the position to hash
+*
+*	 @return
+*	 - unsigned long long :: 64 bit zobrist key
+*********************************************************************/
+unsigned long long position_hash(const Position* pos)
+{
+	zobrist_init();
+
+	unsigned long long hash = 0;
+	for(size_t row = 0; row < NUM_ROWS; ++row)
+		for(size_t col = 0; col < NUM_COLS; ++col)
+		{
+			int index = zobrist_piece_index(pos->squares[row][col]);
+			if(index != FAILURE)
+				hash ^= zobrist_keys[index][row * NUM_COLS + col];
+		}
+	if(pos->side == BLACK)
+		hash ^= zobrist_black_to_move;
+	return hash;
+}
+#endif //ZOBRIST_IMPLEMENTATION_
+#endif //ZOBRIST_H_
@@ -1,10 +1,239 @@
 #include "board.h"
 #include "move.h"
 #include "util.h"
-#include "move_list.h"
+#include "eval.h"
+#include "fen.h"
+#include "search.h"
+#include "stats.h"
+#include "analyze.h"
+#include "self_play.h"
+#include <string.h>
 
-int main(void)
+//positions read and analysed at a time, keeps memory flat on
+//overnight files while leaving each thread plenty to claim
+#define ANALYZE_CHUNK 4096
+
+/*********************************************************************
+* static int run_stats(int argc, char** argv)
+*
+* 	PURPOSE ::
+*  		stats [--json] [depth] [fen]
+*  		search one position and report the engine counters,
+*  		as a table or one JSON object
+*********************************************************************/
+static int run_stats(int argc, char** argv)
+{
+	short json = FALSE;
+	int depth = 6;
+	const char* fen = NULL;
+	for(int i = 0; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--json") == 0)
+			json = TRUE;
+		else if(!fen && strchr(argv[i], '/'))
+			fen = argv[i];
+		else
+			depth = atoi(argv[i]);
+	}
+
+	Position pos;
+	position_init(&pos);
+	if(fen && position_from_fen(&pos, fen) != 0)
+	{
+		fprintf(stderr, "Bad FEN : %s\n", fen);
+		return EXIT_FAILURE;
+	}
+
+	Transposition_Table* tt = tt_create(16 << 20);
+	Search_Context* ctx = search_create(tt);
+	if(!tt || !ctx)
+		error_nomem();
+
+	stats_register_thread();
+	stats_reset();
+	Search_Limits limits = { .depth = depth };
+	Search_Result result;
+	unsigned long long start = time_now_ns();
+	int status = search_position(ctx, &pos, &limits, &result);
+	double seconds = (double)(time_now_ns() - start) / 1e9;
+
+	Engine_Stats stats;
+	stats_collect(&stats);
+	if(json)
+		stats_dump_json(stdout, &stats);
+	else
+	{
+		if(status == 0)
+		{
+			char coord[6];
+			move_to_coord(result.best, coord);
+			printf("depth %d  score %d  best %s  %llu nodes in %.3fs\n",
+					result.depth, result.score, coord, result.nodes, seconds);
+		}
+		stats_print(stdout, &stats);
+	}
+
+	stats_unregister_thread();
+	search_destroy(ctx);
+	tt_destroy(tt);
+	return EXIT_SUCCESS;
+}
+
+/*********************************************************************
+* static int run_analyze(int argc, char** argv)
+*
+* 	PURPOSE ::
+*  		analyze [-j threads] [-d depth] [-m lines] [file]
+*  		search every FEN in <file> (one per line, stdin when
+*  		missing) to <depth> on every core, printing the best
+*  		<lines> root moves of each in input order
+*********************************************************************/
+static int run_analyze(int argc, char** argv)
 {
+	Analyze_Config config;
+	analyze_defaults(&config);
+	const char* path = NULL;
+	for(int i = 0; i < argc; ++i)
+	{
+		if(argv[i][0] == '-' && argv[i][1] != '\0' && argv[i][2] == '\0' && i + 1 < argc)
+		{
+			const char* value = argv[++i];
+			switch(argv[i - 1][1])
+			{
+				case 'j': config.num_threads = (size_t)strtoul(value, NULL, 10); break;
+				case 'd': config.depth = atoi(value); break;
+				case 'm': config.multipv = atoi(value); break;
+				default:
+					fprintf(stderr, "usage: analyze [-j threads] [-d depth] [-m lines] [file]\n");
+					return EXIT_FAILURE;
+			}
+		}
+		else
+			path = argv[i];
+	}
+
+	FILE* in = path ? fopen(path, "r") : stdin;
+	if(!in)
+	{
+		perror("Could not open the position file\n\t{run_analyze}\n");
+		return EXIT_FAILURE;
+	}
+	Analyze_Job* jobs = (Analyze_Job*)malloc(ANALYZE_CHUNK * sizeof(Analyze_Job));
+	if(!jobs)
+		error_nomem();
+
+	int status = EXIT_SUCCESS;
+	size_t index = 0;
+	unsigned long long nodes = 0;
+	unsigned long long start = time_now_ns();
+	char line[256];
+	short more = TRUE;
+	while(more)
+	{
+		size_t count = 0;
+		while(count < ANALYZE_CHUNK && (more = (fgets(line, sizeof(line), in) != NULL)))
+		{
+			line[strcspn(line, "\r\n")] = '\0';
+			if(line[0] == '\0' || line[0] == '#')
+				continue;
+			if(position_from_fen(&jobs[count].position, line) != 0)
+			{
+				fprintf(stderr, "Skipping bad FEN : %s\n", line);
+				continue;
+			}
+			count++;
+		}
+		if(count == 0)
+			break;
+		if(analyze_batch(jobs, count, &config) != 0)
+		{
+			status = EXIT_FAILURE;
+			break;
+		}
+		for(size_t i = 0; i < count; ++i)
+		{
+			analyze_print(stdout, &jobs[i], ++index);
+			nodes += jobs[i].result.nodes;
+		}
+		fflush(stdout);
+	}
+
+	double seconds = (double)(time_now_ns() - start) / 1e9;
+	fprintf(stderr, "%zu positions, %llu nodes in %.1fs (%.0f nodes/s)\n", index, nodes,
+			seconds, (seconds > 0.0) ? (double)nodes / seconds : 0.0);
+	free(jobs);
+	if(in != stdin)
+		fclose(in);
+	return status;
+}
+
+static int selfplay_usage(void)
+{
+	fprintf(stderr, "usage: selfplay [-g games] [-j threads] [-n nodes] [-p plies] [-o output]\n");
+	return EXIT_FAILURE;
+}
+
+/*********************************************************************
+* static int run_selfplay(int argc, char** argv)
+*
+* 	PURPOSE ::
+*  		selfplay [-g games] [-j threads] [-n nodes] [-p plies]
+*  		         [-o output]
+*  		play <games> games against itself, <nodes> per move
+*  		after <plies> random opening moves, and write every
+*  		position searched to <output> for tools/tune
+*********************************************************************/
+static int run_selfplay(int argc, char** argv)
+{
+	Self_Play_Config config;
+	self_play_defaults(&config);
+	for(int i = 0; i < argc; ++i)
+	{
+		if(argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 >= argc)
+			return selfplay_usage();
+		const char* value = argv[++i];
+		char* end;
+		unsigned long long number = strtoull(value, &end, 10);
+		if(argv[i - 1][1] == 'o')
+		{
+			config.output_path = value;
+			continue;
+		}
+		if(end == value || *end != '\0' || value[0] == '-')
+			return selfplay_usage();
+		switch(argv[i - 1][1])
+		{
+			case 'g': config.games = (size_t)number; break;
+			case 'j': config.num_threads = (size_t)number; break;
+			case 'n': config.nodes = number; break;
+			case 'p': config.random_plies = (number > MAX_GAME_PLIES) ? MAX_GAME_PLIES : (int)number; break;
+			default: return selfplay_usage();
+		}
+	}
+	//no node budget would search every move to the depth cap
+	if(config.nodes == 0)
+		return selfplay_usage();
+
+	Self_Play_Stats stats;
+	if(self_play_run(&config, &stats) != 0)
+		return EXIT_FAILURE;
+	self_play_print_stats(&stats);
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+	//tuned weights replace the built-in ones when present
+	if(eval_load_params(EVAL_PARAMS_FILE, &eval_params) == 0)
+		fprintf(stderr, "Loaded evaluation weights from %s\n", EVAL_PARAMS_FILE);
+
+	if(argc > 1 && strcmp(argv[1], "stats") == 0)
+		return run_stats(argc - 2, argv + 2);
+	if(argc > 1 && strcmp(argv[1], "analyze") == 0)
+		return run_analyze(argc - 2, argv + 2);
+	if(argc > 1 && strcmp(argv[1], "selfplay") == 0)
+		return run_selfplay(argc - 2, argv + 2);
+
 	char** board = init_board();
 	if(!board)
 	{
@@ -14,8 +243,7 @@ int main(void)
 	}
 	draw_board(board);
 
-	free_rows(board, NUM_ROWS);
-	free(board);
-	
+	cleanup(board, NUM_ROWS);
+
 	return 0;
 }
@@ -0,0 +1,2 @@
+#define ANALYZE_IMPLEMENTATION_
+#include "analyze.h"
@@ -0,0 +1,2 @@
+#define ARENA_IMPLEMENTATION_
+#include "arena.h"
@@ -0,0 +1,2 @@
+#define BATCH_VALIDATE_IMPLEMENTATION_
+#include "batch_validate.h"
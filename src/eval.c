@@ -0,0 +1,2 @@
+#define EVAL_IMPLEMENTATION_
+#include "eval.h"
@@ -0,0 +1,2 @@
+#define FEN_IMPLEMENTATION_
+#include "fen.h"
@@ -0,0 +1,2 @@
+#define GAME_POOL_IMPLEMENTATION_
+#include "game_pool.h"
@@ -0,0 +1,2 @@
+#define LATENCY_IMPLEMENTATION_
+#include "latency.h"
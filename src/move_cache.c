@@ -0,0 +1,2 @@
+#define MOVE_CACHE_IMPLEMENTATION_
+#include "move_cache.h"
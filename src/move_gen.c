@@ -0,0 +1,2 @@
+#define MOVE_GEN_IMPLEMENTATION_
+#include "move_gen.h"
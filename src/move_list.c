@@ -1,2 +1,2 @@
-#define MOVE_LIST_IMPLEMENTATION
+#define MOVE_LIST_IMPLEMENTATION_
 #include "move_list.h"
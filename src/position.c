@@ -0,0 +1,2 @@
+#define POSITION_IMPLEMENTATION_
+#include "position.h"
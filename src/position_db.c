@@ -0,0 +1,2 @@
+#define POSITION_DB_IMPLEMENTATION_
+#include "position_db.h"
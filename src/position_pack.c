@@ -0,0 +1,2 @@
+#define POSITION_PACK_IMPLEMENTATION_
+#include "position_pack.h"
@@ -0,0 +1,2 @@
+#define RING_QUEUE_IMPLEMENTATION_
+#include "ring_queue.h"
@@ -0,0 +1,2 @@
+#define SEARCH_IMPLEMENTATION_
+#include "search.h"
@@ -0,0 +1,2 @@
+#define SELF_PLAY_IMPLEMENTATION_
+#include "self_play.h"
@@ -0,0 +1,2 @@
+#define STATS_IMPLEMENTATION_
+#include "stats.h"
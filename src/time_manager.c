@@ -0,0 +1,2 @@
+#define TIME_MANAGER_IMPLEMENTATION_
+#include "time_manager.h"
@@ -0,0 +1,2 @@
+#define TT_IMPLEMENTATION_
+#include "tt.h"
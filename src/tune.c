@@ -0,0 +1,2 @@
+#define TUNE_IMPLEMENTATION_
+#include "tune.h"
@@ -0,0 +1,2 @@
+#define ZOBRIST_IMPLEMENTATION_
+#include "zobrist.h"
@@ -0,0 +1,93 @@
+/*********************************************************************
+* tune :: fit the evaluation weights to labelled positions
+*
+* 	usage ::
+*		tune [-t threads] [-e epochs] [-r rate] [-k scale]
+*		     [-i start.params] [-o out.params] data...
+*
+*		-data ending in .bin is "selfplay" output (main.c),
+*		anything else is read as EPD / FEN with results
+*		-the engine loads out.params (EVAL_PARAMS_FILE by
+*		default) at startup
+*
+* 	build ::
+*		cc -std=gnu11 -O3 -march=native -Iinclude tools/tune.c \
+*		   src/board.c src/move.c src/util.c src/position.c \
+*		   src/position_pack.c src/fen.c src/eval.c src/tune.c \
+*		   src/stats.c src/arena.c \
+*		   -lpthread -lm -o tune
+*********************************************************************/
+#include "tune.h"
+#include "eval.h"
+#include "util.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: tune [-t threads] [-e epochs] [-r rate] [-k scale] "
+			"[-i start.params] [-o out.params] data...\n");
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+	Tune_Config config;
+	tune_defaults(&config);
+	const char* input = NULL;
+	const char* output = EVAL_PARAMS_FILE;
+
+	int arg = 1;
+	for(; arg < argc && argv[arg][0] == '-'; ++arg)
+	{
+		if(argv[arg][1] == '\0' || argv[arg][2] != '\0' || arg + 1 >= argc)
+			usage();
+		const char* value = argv[++arg];
+		switch(argv[arg - 1][1])
+		{
+			case 't': config.num_threads = (size_t)strtoul(value, NULL, 10); break;
+			case 'e': config.epochs = atoi(value); break;
+			case 'r': config.learning_rate = atof(value); break;
+			case 'k': config.k = atof(value); break;
+			case 'i': input = value; break;
+			case 'o': output = value; break;
+			default:  usage();
+		}
+	}
+	if(arg == argc)
+		usage();
+
+	Eval_Params params = eval_params;
+	if(input && eval_load_params(input, &params) != 0)
+	{
+		fprintf(stderr, "Could not load %s\n", input);
+		return EXIT_FAILURE;
+	}
+
+	Tune_Set set;
+	tune_set_init(&set);
+	unsigned long long start = time_now_ns();
+	for(; arg < argc; ++arg)
+	{
+		size_t length = strlen(argv[arg]);
+		long added = (length > 4 && strcmp(argv[arg] + length - 4, ".bin") == 0)
+			? tune_load_self_play(&set, argv[arg])
+			: tune_load_epd(&set, argv[arg]);
+		if(added < 0)
+		{
+			tune_set_free(&set);
+			return EXIT_FAILURE;
+		}
+	}
+	printf("loaded %zu positions in %.1fs\n", set.count, (double)(time_now_ns() - start) / 1e9);
+
+	double error = tune_run(&set, &params, &config);
+	printf("final error %.6f\n", error);
+	tune_set_free(&set);
+
+	if(eval_save_params(output, &params) != 0)
+		return EXIT_FAILURE;
+	printf("wrote %s\n", output);
+	return 0;
+}